@@ -1,4 +1,5 @@
 #include "buffers.hpp"
+#include "render_stats.hpp"
 #include <cstring>
 
 namespace lavander 
@@ -21,12 +22,15 @@ namespace lavander
             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
             vertexBuffer,
-            vertexBufferMemory);
+            vertexBufferMemory,
+            MemoryCategory::Mesh,
+            "vertex buffer");
 
         void* vertexData;
         vkMapMemory(deviceRef.device(), vertexBufferMemory, 0, vertexBufferSize, 0, &vertexData);
         memcpy(vertexData, vertices.data(), static_cast<size_t>(vertexBufferSize));
         vkUnmapMemory(deviceRef.device(), vertexBufferMemory);
+        RenderStats::Get().countBufferUpload(vertexBufferSize);
 
 
         if (hasIndexBuffer) 
@@ -38,25 +42,35 @@ namespace lavander
                 VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                 indexBuffer,
-                indexBufferMemory);
+                indexBufferMemory,
+                MemoryCategory::Mesh,
+                "index buffer");
 
             void* indexData;
             vkMapMemory(deviceRef.device(), indexBufferMemory, 0, indexBufferSize, 0, &indexData);
             memcpy(indexData, indices.data(), static_cast<size_t>(indexBufferSize));
             vkUnmapMemory(deviceRef.device(), indexBufferMemory);
+            RenderStats::Get().countBufferUpload(indexBufferSize);
         }
     }
 
     c_buffers::~c_buffers()
     {
-        if (hasIndexBuffer)
+        //in flight frames may still draw from these, let the device free them once they retired
+        VkDevice dev = deviceRef.device();
+        c_device* device = &deviceRef;
+        deviceRef.deferDestroy([dev, device, vb = vertexBuffer, vbMem = vertexBufferMemory,
+            ib = hasIndexBuffer ? indexBuffer : VK_NULL_HANDLE, ibMem = hasIndexBuffer ? indexBufferMemory : VK_NULL_HANDLE]()
         {
-            vkDestroyBuffer(deviceRef.device(), indexBuffer, nullptr);
-            vkFreeMemory(deviceRef.device(), indexBufferMemory, nullptr);
-        }
+            if (ib)
+            {
+                vkDestroyBuffer(dev, ib, c_device::allocator());
+                device->freeMemory(ibMem);
+            }
 
-        vkDestroyBuffer(deviceRef.device(), vertexBuffer, nullptr);
-        vkFreeMemory(deviceRef.device(), vertexBufferMemory, nullptr);
+            vkDestroyBuffer(dev, vb, c_device::allocator());
+            device->freeMemory(vbMem);
+        });
     }
 
     void c_buffers::bind(VkCommandBuffer commandBuffer) 
@@ -76,10 +90,12 @@ namespace lavander
         if (hasIndexBuffer)
         {
             vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+            RenderStats::Get().countDraw(1, indexCount / 3);
         }
         else
         {
             vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+            RenderStats::Get().countDraw(1, vertexCount / 3);
         }
     }
 
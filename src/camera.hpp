@@ -35,6 +35,8 @@ namespace lavander
         float getFovDegrees() const { return fovDeg; }
         float getNearClip() const { return near; }
         float getFarClip() const { return far; }
+        const glm::vec3& getPosition() const { return position; }
+        const glm::vec3& getForward() const { return forward; }
         const glm::mat4& getView() const { return view; }
         const glm::mat4& getProj() const { return proj; }
         glm::mat4 getViewProj() const { return proj * view; }
@@ -1,8 +1,10 @@
 #pragma once
 #include "entity.hpp"
 
+#include <cstddef>
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 namespace lavander 
 {
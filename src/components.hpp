@@ -23,6 +23,7 @@ namespace lavander
     {
         glm::vec3 color = glm::vec3(1.0f);
         std::shared_ptr<Texture2D> texture;
+        bool alphaTest = false; // cut out texels under half alpha
     };
     
     struct MeshFilter 
@@ -33,6 +34,7 @@ namespace lavander
     struct MeshRenderer3D {
         std::shared_ptr<Texture2D> texture;
         glm::vec3 color{ 1,1,1 };
+        bool lit = true;
     };
 
     struct PushConst
@@ -0,0 +1,245 @@
+#include "cpu_profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <imgui.h>
+
+namespace lavander
+{
+    namespace
+    {
+        thread_local void* tlsBuffer = nullptr;
+    }
+
+    CpuProfiler& CpuProfiler::Get()
+    {
+        static CpuProfiler profiler;
+        return profiler;
+    }
+
+    int64_t CpuProfiler::Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    CpuProfiler::ThreadBuffer& CpuProfiler::local()
+    {
+        if (tlsBuffer) return *static_cast<ThreadBuffer*>(tlsBuffer);
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffers.back()->name = "Thread " + std::to_string(buffers.size() - 1);
+        tlsBuffer = buffers.back().get();
+        return *buffers.back();
+    }
+
+    void CpuProfiler::setThreadName(const std::string& name)
+    {
+        ThreadBuffer& buffer = local();
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffer.name = name;
+    }
+
+    uint32_t CpuProfiler::enter()
+    {
+        return local().depth++;
+    }
+
+    void CpuProfiler::leave(const char* name, int64_t beginNs, int64_t endNs, uint32_t depth)
+    {
+        ThreadBuffer& buffer = local();
+        buffer.depth = depth;
+
+        uint32_t head = buffer.head.load(std::memory_order_relaxed);
+        if (head - buffer.tail.load(std::memory_order_acquire) >= kCapacity)
+        {
+            //the frame hasn't been drained in a while, better lose events than block
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer.events[head % kCapacity] = { name, beginNs, endNs, depth };
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void CpuProfiler::endFrame()
+    {
+        int64_t now = Now();
+        std::vector<ThreadFrame> next;
+        droppedLastFrame = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            for (auto& buffer : buffers)
+            {
+                uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+                uint32_t head = buffer->head.load(std::memory_order_acquire);
+                droppedLastFrame += buffer->dropped.exchange(0, std::memory_order_relaxed);
+
+                scratch.clear();
+                for (uint32_t i = tail; i != head; i++) scratch.push_back(buffer->events[i % kCapacity]);
+                buffer->tail.store(head, std::memory_order_release);
+
+                if (scratch.empty()) continue;
+
+                next.emplace_back();
+                next.back().name = buffer->name;
+                next.back().events = scratch;
+            }
+        }
+
+        for (ThreadFrame& thread : next) buildTree(thread);
+        latest.threads = std::move(next);
+        latest.beginNs = latest.endNs ? latest.endNs : now;
+        latest.endNs = now;
+    }
+
+    void CpuProfiler::setPaused(bool paused)
+    {
+        if (paused && !this->paused) held = latest;
+        this->paused = paused;
+    }
+
+    void CpuProfiler::buildTree(ThreadFrame& thread)
+    {
+        //scopes are recorded as they end, children before their parent
+        std::sort(thread.events.begin(), thread.events.end(), [](const Event& a, const Event& b)
+            {
+                return a.beginNs != b.beginNs ? a.beginNs < b.beginNs : a.depth < b.depth;
+            });
+
+        std::vector<Node*> stack;
+        for (const Event& e : thread.events)
+        {
+            //parents that started in an earlier frame are missing, hang their children off the nearest one
+            while (!stack.empty() && stack.size() > e.depth) stack.pop_back();
+
+            std::vector<Node>& siblings = stack.empty() ? thread.roots : stack.back()->children;
+            auto it = std::find_if(siblings.begin(), siblings.end(),
+                [&](const Node& n) { return std::strcmp(n.name, e.name) == 0; });
+            if (it == siblings.end())
+            {
+                siblings.emplace_back();
+                siblings.back().name = e.name;
+                it = siblings.end() - 1;
+            }
+
+            it->ms += double(e.endNs - e.beginNs) * 1e-6;
+            it->calls++;
+            stack.push_back(&*it);
+        }
+    }
+
+    void CpuProfiler::OnImGuiRender()
+    {
+        ImGui::Begin("CPU Profiler");
+
+#if !LAVANDER_PROFILE
+        ImGui::TextUnformatted("Built without LAVANDER_PROFILE, PROFILE_SCOPE records nothing.");
+#endif
+
+        const Snapshot& shown = paused ? held : latest;
+
+        bool pause = paused;
+        if (ImGui::Checkbox("Pause", &pause)) setPaused(pause);
+        ImGui::SameLine();
+        ImGui::Text("frame %.2f ms", double(shown.endNs - shown.beginNs) * 1e-6);
+        if (droppedLastFrame)
+        {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%u events dropped", droppedLastFrame);
+        }
+
+        if (ImGui::BeginTabBar("##cpu_profiler_tabs"))
+        {
+            if (ImGui::BeginTabItem("Flame graph"))
+            {
+                drawTimeline(shown);
+                ImGui::EndTabItem();
+            }
+            if (ImGui::BeginTabItem("Tree"))
+            {
+                for (const ThreadFrame& thread : shown.threads)
+                {
+                    if (ImGui::TreeNodeEx(thread.name.c_str(), ImGuiTreeNodeFlags_DefaultOpen))
+                    {
+                        drawTree(thread.roots);
+                        ImGui::TreePop();
+                    }
+                }
+                ImGui::EndTabItem();
+            }
+            ImGui::EndTabBar();
+        }
+
+        ImGui::End();
+    }
+
+    void CpuProfiler::drawTimeline(const Snapshot& shown)
+    {
+        const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+        const double frameNs = double(std::max<int64_t>(1, shown.endNs - shown.beginNs));
+
+        for (const ThreadFrame& thread : shown.threads)
+        {
+            ImGui::TextUnformatted(thread.name.c_str());
+
+            uint32_t maxDepth = 0;
+            for (const Event& e : thread.events) maxDepth = std::max(maxDepth, e.depth);
+
+            ImVec2 origin = ImGui::GetCursorScreenPos();
+            float width = std::max(1.0f, ImGui::GetContentRegionAvail().x);
+            ImDrawList* draw = ImGui::GetWindowDrawList();
+
+            for (const Event& e : thread.events)
+            {
+                //clip scopes that began in the previous frame
+                double x0 = std::max(0.0, double(e.beginNs - shown.beginNs) / frameNs);
+                double x1 = std::min(1.0, double(e.endNs - shown.beginNs) / frameNs);
+                if (x1 <= x0) continue;
+
+                ImVec2 a(origin.x + float(x0) * width, origin.y + e.depth * rowHeight);
+                ImVec2 b(origin.x + float(x1) * width, a.y + rowHeight - 1.0f);
+
+                //stable colour per name
+                uint32_t hash = 2166136261u;
+                for (const char* c = e.name; *c; c++) hash = (hash ^ uint8_t(*c)) * 16777619u;
+                ImU32 color = IM_COL32(80 + hash % 120, 80 + (hash >> 8) % 120, 80 + (hash >> 16) % 120, 255);
+
+                draw->AddRectFilled(a, b, color);
+                if (b.x - a.x > 30.0f)
+                {
+                    draw->PushClipRect(a, b, true);
+                    draw->AddText(ImVec2(a.x + 2.0f, a.y), IM_COL32_WHITE, e.name);
+                    draw->PopClipRect();
+                }
+
+                if (ImGui::IsMouseHoveringRect(a, b))
+                {
+                    ImGui::SetTooltip("%s\n%.3f ms", e.name, double(e.endNs - e.beginNs) * 1e-6);
+                }
+            }
+
+            ImGui::Dummy(ImVec2(width, (maxDepth + 1) * rowHeight));
+        }
+    }
+
+    void CpuProfiler::drawTree(const std::vector<Node>& nodes)
+    {
+        for (const Node& n : nodes)
+        {
+            ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_SpanAvailWidth;
+            if (n.children.empty()) flags |= ImGuiTreeNodeFlags_Leaf;
+
+            bool open = ImGui::TreeNodeEx(n.name, flags, "%s  %.3f ms  x%u", n.name, n.ms, n.calls);
+            if (open)
+            {
+                drawTree(n.children);
+                ImGui::TreePop();
+            }
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//set by CMake (LAVANDER_PROFILE option), PROFILE_SCOPE compiles to nothing without it
+#ifndef LAVANDER_PROFILE
+#define LAVANDER_PROFILE 0
+#endif
+
+namespace lavander
+{
+    // Hierarchical CPU scopes. Each thread records finished scopes into its own
+    // single-producer ring, so recording never takes a lock; the main thread drains every
+    // ring once per frame and folds the events into a call tree for the profiler panel.
+    class CpuProfiler
+    {
+    public:
+        struct Event
+        {
+            const char* name;   // static storage, string literals
+            int64_t     beginNs;
+            int64_t     endNs;
+            uint32_t    depth;
+        };
+
+        //same-named scopes under the same parent summed up
+        struct Node
+        {
+            const char* name = nullptr;
+            double   ms = 0.0;
+            uint32_t calls = 0;
+            std::vector<Node> children;
+        };
+
+        struct ThreadFrame
+        {
+            std::string name;
+            std::vector<Event> events; // sorted by begin
+            std::vector<Node> roots;
+        };
+
+        static CpuProfiler& Get();
+        static int64_t Now();
+
+        //labels the calling thread in the panel
+        void setThreadName(const std::string& name);
+
+        //CpuScope's halves, enter returns the scope's depth
+        uint32_t enter();
+        void leave(const char* name, int64_t beginNs, int64_t endNs, uint32_t depth);
+
+        //main thread, once per frame: everything recorded since the last call becomes the frame
+        void endFrame();
+
+        //always the newest frame, pausing only freezes the panel
+        const std::vector<ThreadFrame>& lastFrame() const { return latest.threads; }
+        int64_t lastFrameBeginNs() const { return latest.beginNs; }
+        double lastFrameMs() const { return double(latest.endNs - latest.beginNs) * 1e-6; }
+
+        void setPaused(bool paused);
+        bool isPaused() const { return paused; }
+
+        void OnImGuiRender();
+
+    private:
+        static constexpr uint32_t kCapacity = 8192;
+
+        struct Snapshot
+        {
+            std::vector<ThreadFrame> threads;
+            int64_t beginNs = 0;
+            int64_t endNs = 0;
+        };
+
+        struct ThreadBuffer
+        {
+            Event events[kCapacity];
+            std::atomic<uint32_t> head{ 0 }; // written by the owning thread only
+            std::atomic<uint32_t> tail{ 0 }; // written by the draining thread only
+            std::atomic<uint32_t> dropped{ 0 };
+            uint32_t    depth = 0;
+            std::string name;
+        };
+
+        CpuProfiler() = default;
+
+        ThreadBuffer& local();
+        static void buildTree(ThreadFrame& thread);
+        void drawTimeline(const Snapshot& shown);
+        void drawTree(const std::vector<Node>& nodes);
+
+        //registration only, threads record without it. Buffers outlive their threads.
+        std::mutex buffersMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+        Snapshot latest;
+        Snapshot held; // what the panel shows while paused
+        std::vector<Event> scratch;
+        uint32_t droppedLastFrame = 0;
+        bool paused = false;
+    };
+
+    class CpuScope
+    {
+    public:
+        explicit CpuScope(const char* name)
+            : name(name), depth(CpuProfiler::Get().enter()), beginNs(CpuProfiler::Now()) {}
+        ~CpuScope() { CpuProfiler::Get().leave(name, beginNs, CpuProfiler::Now(), depth); }
+
+        CpuScope(const CpuScope&) = delete;
+        CpuScope& operator=(const CpuScope&) = delete;
+
+    private:
+        const char* name;
+        uint32_t    depth;
+        int64_t     beginNs;
+    };
+}
+
+#if LAVANDER_PROFILE
+#define LAVANDER_PROFILE_JOIN2(a, b) a##b
+#define LAVANDER_PROFILE_JOIN(a, b) LAVANDER_PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(name) ::lavander::CpuScope LAVANDER_PROFILE_JOIN(profileScope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,43 @@
+#include "deletion_queue.hpp"
+
+#include <vector>
+
+namespace lavander
+{
+    void DeletionQueue::push(uint64_t value, std::function<void()> destroy)
+    {
+        if (!destroy) return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.push_back({ value, std::move(destroy) });
+    }
+
+    size_t DeletionQueue::collect(uint64_t completedValue)
+    {
+        //take the ready ones out first, callbacks may push more (a mesh releasing its buffers)
+        std::vector<std::function<void()>> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (!entries.empty() && entries.front().value <= completedValue)
+            {
+                ready.push_back(std::move(entries.front().destroy));
+                entries.pop_front();
+            }
+        }
+
+        for (auto& destroy : ready) destroy();
+        return ready.size();
+    }
+
+    void DeletionQueue::flush()
+    {
+        //callbacks can queue further deletions, keep going until it's empty
+        while (collect(UINT64_MAX) > 0) {}
+    }
+
+    size_t DeletionQueue::size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace lavander
+{
+    // Destroy callbacks tagged with the graphics timeline value of the last submission that
+    // could reference the resource. collect() runs everything the GPU has finished with,
+    // so releasing resources never has to wait for the device.
+    class DeletionQueue
+    {
+    public:
+        DeletionQueue() = default;
+        ~DeletionQueue() { flush(); }
+
+        DeletionQueue(const DeletionQueue&) = delete;
+        DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+        //values must not decrease between pushes, the device tags with its last submitted value
+        void push(uint64_t value, std::function<void()> destroy);
+
+        //runs every callback tagged at or below completedValue, returns how many ran
+        size_t collect(uint64_t completedValue);
+
+        //runs everything, only once the device is idle
+        void flush();
+
+        size_t size();
+
+    private:
+        struct Entry
+        {
+            uint64_t value;
+            std::function<void()> destroy;
+        };
+
+        std::mutex mutex;
+        std::deque<Entry> entries;
+    };
+}
@@ -0,0 +1,164 @@
+#include "descriptor_allocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace lavander
+{
+    namespace
+    {
+        //pools double in size as the chain grows, up to this many sets
+        constexpr uint32_t kMaxSetsPerPool = 4096;
+    }
+
+    std::vector<DescriptorAllocator::PoolRatio> DescriptorAllocator::DefaultRatios()
+    {
+        return {
+            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f },
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+        };
+    }
+
+    DescriptorAllocator::DescriptorAllocator(c_device& device, Mode mode, uint32_t framesInFlight,
+        std::vector<PoolRatio> ratios, uint32_t setsPerPool)
+        : device(device), mode_(mode), framesInFlight(framesInFlight), ratios(std::move(ratios)), setsPerPool(setsPerPool)
+    {
+    }
+
+    DescriptorAllocator::~DescriptorAllocator()
+    {
+        VkDevice dev = device.device();
+        for (VkDescriptorPool pool : fullPools) vkDestroyDescriptorPool(dev, pool, c_device::allocator());
+        for (VkDescriptorPool pool : readyPools) vkDestroyDescriptorPool(dev, pool, c_device::allocator());
+        if (current) vkDestroyDescriptorPool(dev, current, c_device::allocator());
+    }
+
+    VkDescriptorPool DescriptorAllocator::createPool()
+    {
+        std::vector<VkDescriptorPoolSize> sizes;
+        for (const PoolRatio& r : ratios)
+        {
+            sizes.push_back({ r.type, std::max(1u, uint32_t(r.perSet * float(setsPerPool))) });
+        }
+
+        VkDescriptorPoolCreateInfo ci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+        ci.maxSets = setsPerPool;
+        ci.poolSizeCount = uint32_t(sizes.size());
+        ci.pPoolSizes = sizes.data();
+
+        VkDescriptorPool pool;
+        if (vkCreateDescriptorPool(device.device(), &ci, c_device::allocator(), &pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+
+        setsPerPool = std::min(setsPerPool * 2, kMaxSetsPerPool);
+        stats_.pools++;
+        return pool;
+    }
+
+    VkDescriptorPool DescriptorAllocator::nextPool()
+    {
+        if (!readyPools.empty())
+        {
+            VkDescriptorPool pool = readyPools.back();
+            readyPools.pop_back();
+            return pool;
+        }
+        return createPool();
+    }
+
+    VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+    {
+        stats_.setsThisFrame++;
+
+        if (mode_ == Mode::Persistent)
+        {
+            auto it = freeSets.find(layout);
+            if (it != freeSets.end() && !it->second.empty())
+            {
+                VkDescriptorSet set = it->second.back();
+                it->second.pop_back();
+                stats_.recycledThisFrame++;
+                stats_.liveSets++;
+                return set;
+            }
+        }
+
+        if (!current) current = nextPool();
+
+        VkDescriptorSetAllocateInfo ai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        ai.descriptorPool = current;
+        ai.descriptorSetCount = 1;
+        ai.pSetLayouts = &layout;
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkResult result = vkAllocateDescriptorSets(device.device(), &ai, &set);
+        if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+        {
+            //this pool is done, chain a new one and try once more
+            fullPools.push_back(current);
+            current = nextPool();
+            ai.descriptorPool = current;
+            result = vkAllocateDescriptorSets(device.device(), &ai, &set);
+        }
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate descriptor set!");
+        }
+
+        stats_.setsTotal++;
+        stats_.liveSets++;
+        return set;
+    }
+
+    void DescriptorAllocator::free(VkDescriptorSet set, VkDescriptorSetLayout layout)
+    {
+        if (set == VK_NULL_HANDLE) return;
+        if (mode_ != Mode::Persistent)
+        {
+            throw std::runtime_error("transient descriptor sets are released by reset()!");
+        }
+
+        pending.push_back({ frame, set, layout });
+        stats_.liveSets--;
+    }
+
+    void DescriptorAllocator::beginFrame()
+    {
+        frame++;
+        stats_.setsThisFrame = 0;
+        stats_.recycledThisFrame = 0;
+
+        //sets freed framesInFlight frames ago can't be bound by anything still executing
+        auto done = std::partition(pending.begin(), pending.end(),
+            [this](const PendingFree& p) { return p.frame + framesInFlight > frame; });
+        for (auto it = done; it != pending.end(); ++it)
+        {
+            freeSets[it->layout].push_back(it->set);
+        }
+        pending.erase(done, pending.end());
+    }
+
+    void DescriptorAllocator::reset()
+    {
+        if (mode_ != Mode::Transient)
+        {
+            throw std::runtime_error("only transient descriptor allocators can be reset!");
+        }
+
+        VkDevice dev = device.device();
+        if (current)
+        {
+            fullPools.push_back(current);
+            current = VK_NULL_HANDLE;
+        }
+        for (VkDescriptorPool pool : fullPools)
+        {
+            vkResetDescriptorPool(dev, pool, 0);
+            readyPools.push_back(pool);
+        }
+        fullPools.clear();
+        stats_.liveSets = 0;
+    }
+}
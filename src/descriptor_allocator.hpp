@@ -0,0 +1,85 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "device.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace lavander
+{
+    // Hands out descriptor sets from a chain of pools, a new pool is added whenever the
+    // current one runs out so there is no fixed set limit.
+    //
+    // Persistent: sets live until free()d. Freed sets wait out the frames in flight and
+    //             are then recycled for the next allocation with the same layout.
+    // Transient:  sets only live for one frame, reset() recycles every pool at once.
+    class DescriptorAllocator
+    {
+    public:
+        enum class Mode { Persistent, Transient };
+
+        // descriptors of each type reserved per set when sizing a pool
+        struct PoolRatio
+        {
+            VkDescriptorType type;
+            float perSet;
+        };
+
+        struct Stats
+        {
+            uint32_t setsThisFrame = 0;
+            uint32_t recycledThisFrame = 0;
+            uint64_t setsTotal = 0;
+            uint32_t liveSets = 0;
+            uint32_t pools = 0;
+        };
+
+        DescriptorAllocator(c_device& device, Mode mode, uint32_t framesInFlight,
+            std::vector<PoolRatio> ratios = DefaultRatios(), uint32_t setsPerPool = 256);
+        ~DescriptorAllocator();
+
+        DescriptorAllocator(const DescriptorAllocator&) = delete;
+        DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+        VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+        //persistent only, the set is reused once the frames that may still bind it are done
+        void free(VkDescriptorSet set, VkDescriptorSetLayout layout);
+
+        //call once per frame after that frame's fence was waited on
+        void beginFrame();
+        //transient only, returns every set to its pool
+        void reset();
+
+        const Stats& stats() const { return stats_; }
+        Mode mode() const { return mode_; }
+
+        static std::vector<PoolRatio> DefaultRatios();
+
+    private:
+        struct PendingFree
+        {
+            uint64_t frame;
+            VkDescriptorSet set;
+            VkDescriptorSetLayout layout;
+        };
+
+        VkDescriptorPool createPool();
+        VkDescriptorPool nextPool();
+
+        c_device& device;
+        Mode mode_;
+        uint32_t framesInFlight;
+        std::vector<PoolRatio> ratios;
+        uint32_t setsPerPool;
+
+        std::vector<VkDescriptorPool> fullPools;
+        std::vector<VkDescriptorPool> readyPools;
+        VkDescriptorPool current = VK_NULL_HANDLE;
+
+        std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> freeSets;
+        std::vector<PendingFree> pending;
+
+        uint64_t frame = 0;
+        Stats stats_;
+    };
+}
@@ -1,7 +1,10 @@
 #include "device.hpp"
 
 // std headers
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -47,25 +50,54 @@ void DestroyDebugUtilsMessengerEXT(
 }
 
 // class member functions
-c_device::c_device(c_window &window) : window{window} {
+c_device::c_device(c_window *window) : window{window} {
+  if (headless()) {
+    deviceExtensions.clear();
+  }
   createInstance();
   setupDebugMessenger();
   createSurface();
   pickPhysicalDevice();
   createLogicalDevice();
   createCommandPool();
+  createPipelineCache();
+  createTimeline();
 }
 
 c_device::~c_device() {
-  vkDestroyCommandPool(device_, commandPool, nullptr);
-  vkDestroyDevice(device_, nullptr);
+  vkDeviceWaitIdle(device_);
+  // before the samplers, deferred textures still release theirs
+  deletionQueue.flush();
+  if (graphicsTimeline_) {
+    vkDestroySemaphore(device_, graphicsTimeline_, allocator());
+  }
+  for (auto &pending : pendingFences) {
+    vkDestroyFence(device_, pending.fence, allocator());
+  }
+  for (VkFence fence : freeFences) {
+    vkDestroyFence(device_, fence, allocator());
+  }
+  for (VkFence fence : retiredFences) {
+    vkDestroyFence(device_, fence, allocator());
+  }
+  for (auto &entry : samplers) {
+    vkDestroySampler(device_, entry.second.sampler, allocator());
+  }
+  if (pipelineCache_) {
+    savePipelineCache();
+    vkDestroyPipelineCache(device_, pipelineCache_, allocator());
+  }
+  vkDestroyCommandPool(device_, commandPool, allocator());
+  vkDestroyDevice(device_, allocator());
 
   if (enableValidationLayers) {
-    DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+    DestroyDebugUtilsMessengerEXT(instance, debugMessenger, allocator());
   }
 
-  vkDestroySurfaceKHR(instance, surface_, nullptr);
-  vkDestroyInstance(instance, nullptr);
+  if (surface_) {
+    vkDestroySurfaceKHR(instance, surface_, allocator());
+  }
+  vkDestroyInstance(instance, allocator());
 }
 
 void c_device::createInstance() {
@@ -79,7 +111,16 @@ void c_device::createInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  // timeline semaphores are core in 1.2, use it when the loader has it
+  auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(
+      nullptr,
+      "vkEnumerateInstanceVersion");
+  if (enumerateInstanceVersion != nullptr) {
+    enumerateInstanceVersion(&instanceApiVersion_);
+  }
+  instanceApiVersion_ =
+      instanceApiVersion_ >= VK_API_VERSION_1_2 ? VK_API_VERSION_1_2 : VK_API_VERSION_1_0;
+  appInfo.apiVersion = instanceApiVersion_;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -101,7 +142,7 @@ void c_device::createInstance() {
     createInfo.pNext = nullptr;
   }
 
-  if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
+  if (vkCreateInstance(&createInfo, allocator(), &instance) != VK_SUCCESS) {
     throw std::runtime_error("failed to create instance!");
   }
 
@@ -149,8 +190,39 @@ void c_device::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // cooked .ktx2 textures are BCn, enable it wherever the hardware has it
+  deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
+  // timeline semaphores need both a 1.2 instance and a 1.2 device
+  VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = {};
+  timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+  if (instanceApiVersion_ >= VK_API_VERSION_1_2 && properties.apiVersion >= VK_API_VERSION_1_2) {
+    VkPhysicalDeviceFeatures2 features2 = {};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &timelineFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+    timelineSupported_ = timelineFeatures.timelineSemaphore == VK_TRUE;
+  }
+
+  // per heap budget and usage, needs vkGetPhysicalDeviceMemoryProperties2 from the 1.2 instance
+  std::vector<const char *> enabledExtensions = deviceExtensions;
+  if (instanceApiVersion_ >= VK_API_VERSION_1_2) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> available(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, available.data());
+    for (const auto &extension : available) {
+      if (std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+        memoryBudgetSupported_ = true;
+        enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+      }
+    }
+  }
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -159,8 +231,11 @@ void c_device::createLogicalDevice() {
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  if (timelineSupported_) {
+    createInfo.pNext = &timelineFeatures;
+  }
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -171,10 +246,13 @@ void c_device::createLogicalDevice() {
     createInfo.enabledLayerCount = 0;
   }
 
-  if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device_) != VK_SUCCESS) {
+  if (vkCreateDevice(physicalDevice, &createInfo, allocator(), &device_) != VK_SUCCESS) {
     throw std::runtime_error("failed to create logical device!");
   }
 
+  memoryTracker_.init(physicalDevice, memoryBudgetSupported_);
+  memoryTracker_.refreshBudget();
+
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
 }
@@ -188,20 +266,24 @@ void c_device::createCommandPool() {
   poolInfo.flags =
       VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-  if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+  if (vkCreateCommandPool(device_, &poolInfo, allocator(), &commandPool) != VK_SUCCESS) {
     throw std::runtime_error("failed to create command pool!");
   }
 }
 
-void c_device::createSurface() { window.createWindowSurface(instance, &surface_); }
+void c_device::createSurface() {
+  if (window) {
+    window->createWindowSurface(instance, &surface_);
+  }
+}
 
 bool c_device::isDeviceSuitable(VkPhysicalDevice device) {
   QueueFamilyIndices indices = findQueueFamilies(device);
 
   bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
+  bool swapChainAdequate = headless();
+  if (extensionsSupported && !headless()) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
@@ -230,7 +312,7 @@ void c_device::setupDebugMessenger() {
   if (!enableValidationLayers) return;
   VkDebugUtilsMessengerCreateInfoEXT createInfo;
   populateDebugMessengerCreateInfo(createInfo);
-  if (CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS) {
+  if (CreateDebugUtilsMessengerEXT(instance, &createInfo, allocator(), &debugMessenger) != VK_SUCCESS) {
     throw std::runtime_error("failed to set up debug messenger!");
   }
 }
@@ -261,11 +343,13 @@ bool c_device::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> c_device::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char *> extensions;
+  if (window) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -332,8 +416,13 @@ QueueFamilyIndices c_device::findQueueFamilies(VkPhysicalDevice device) {
       indices.graphicsFamily = i;
       indices.graphicsFamilyHasValue = true;
     }
+    // headless presents nowhere, the graphics queue stands in for the present queue
     VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    if (surface_) {
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    } else {
+      presentSupport = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT ? VK_TRUE : VK_FALSE;
+    }
     if (queueFamily.queueCount > 0 && presentSupport) {
       indices.presentFamily = i;
       indices.presentFamilyHasValue = true;
@@ -408,14 +497,16 @@ void c_device::createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    VkDeviceMemory &bufferMemory,
+    MemoryCategory category,
+    const std::string &owner) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
   bufferInfo.usage = usage;
   bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-  if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+  if (vkCreateBuffer(device_, &bufferInfo, allocator(), &buffer) != VK_SUCCESS) {
     throw std::runtime_error("failed to create vertex buffer!");
   }
 
@@ -427,13 +518,24 @@ void c_device::createBuffer(
   allocInfo.allocationSize = memRequirements.size;
   allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
+  if (vkAllocateMemory(device_, &allocInfo, allocator(), &bufferMemory) != VK_SUCCESS) {
     throw std::runtime_error("failed to allocate vertex buffer memory!");
   }
+  allocationCount_.fetch_add(1, std::memory_order_relaxed);
+  memoryTracker_.onAllocate(bufferMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, category, owner);
+  if ((usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) && (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+    uploadBytes_.fetch_add(size, std::memory_order_relaxed);
+  }
 
   vkBindBufferMemory(device_, buffer, bufferMemory, 0);
 }
 
+void c_device::freeMemory(VkDeviceMemory memory) {
+  if (memory == VK_NULL_HANDLE) return;
+  memoryTracker_.onFree(memory);
+  vkFreeMemory(device_, memory, allocator());
+}
+
 VkCommandBuffer c_device::beginSingleTimeCommands() {
   VkCommandBufferAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -460,12 +562,150 @@ void c_device::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphicsQueue_);
+  waitForValue(submitGraphics(submitInfo));
 
   vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
 }
 
+void c_device::createTimeline() {
+  if (!timelineSupported_) {
+    std::cout << "timeline semaphores unavailable, using fences" << std::endl;
+    return;
+  }
+
+  VkSemaphoreTypeCreateInfo typeInfo = {};
+  typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  typeInfo.initialValue = 0;
+
+  VkSemaphoreCreateInfo createInfo = {};
+  createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  createInfo.pNext = &typeInfo;
+
+  if (vkCreateSemaphore(device_, &createInfo, allocator(), &graphicsTimeline_) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create timeline semaphore!");
+  }
+}
+
+uint64_t c_device::submitGraphics(const VkSubmitInfo &submitInfo) {
+  std::lock_guard<std::mutex> lock(submitMutex);
+  const uint64_t value = submittedValue_ + 1;
+
+  VkSubmitInfo info = submitInfo;
+  VkFence fence = VK_NULL_HANDLE;
+
+  // the caller's binary semaphores keep working, their values are ignored
+  std::vector<VkSemaphore> signalSemaphores;
+  std::vector<uint64_t> signalValues;
+  VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+
+  if (timelineSupported_) {
+    signalSemaphores.assign(info.pSignalSemaphores, info.pSignalSemaphores + info.signalSemaphoreCount);
+    signalValues.assign(signalSemaphores.size(), 0);
+    signalSemaphores.push_back(graphicsTimeline_);
+    signalValues.push_back(value);
+
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.pNext = info.pNext;
+    timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+    timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+    info.pNext = &timelineInfo;
+    info.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+    info.pSignalSemaphores = signalSemaphores.data();
+  } else {
+    if (freeFences.empty()) {
+      VkFenceCreateInfo fenceInfo = {};
+      fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+      if (vkCreateFence(device_, &fenceInfo, allocator(), &fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create submit fence!");
+      }
+    } else {
+      fence = freeFences.back();
+      freeFences.pop_back();
+    }
+  }
+
+  if (vkQueueSubmit(graphicsQueue_, 1, &info, fence) != VK_SUCCESS) {
+    if (fence) freeFences.push_back(fence);
+    throw std::runtime_error("failed to submit to the graphics queue!");
+  }
+
+  if (fence) pendingFences.push_back({value, fence});
+  submittedValue_ = value;
+  return value;
+}
+
+void c_device::deferDestroy(std::function<void()> destroy) {
+  // anything recorded so far has been submitted, the last value covers every use
+  deletionQueue.push(submittedValue_, std::move(destroy));
+}
+
+void c_device::retireFences() {
+  // one queue, so fences signal in submission order
+  while (!pendingFences.empty() &&
+         vkGetFenceStatus(device_, pendingFences.front().fence) == VK_SUCCESS) {
+    PendingFence done = pendingFences.front();
+    pendingFences.pop_front();
+    retiredFences.push_back(done.fence);
+    completedValue_ = done.value;
+  }
+
+  // a waiter outside the lock may hold any of them, resetting one would leave it waiting forever
+  if (fenceWaiters_ == 0 && !retiredFences.empty()) {
+    vkResetFences(device_, static_cast<uint32_t>(retiredFences.size()), retiredFences.data());
+    freeFences.insert(freeFences.end(), retiredFences.begin(), retiredFences.end());
+    retiredFences.clear();
+  }
+}
+
+uint64_t c_device::completedValue() {
+  if (timelineSupported_) {
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(device_, graphicsTimeline_, &value);
+    return value;
+  }
+
+  std::lock_guard<std::mutex> lock(submitMutex);
+  retireFences();
+  return completedValue_;
+}
+
+void c_device::waitForValue(uint64_t value) {
+  if (value == 0) return;
+
+  if (timelineSupported_) {
+    VkSemaphoreWaitInfo waitInfo = {};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &graphicsTimeline_;
+    waitInfo.pValues = &value;
+    vkWaitSemaphores(device_, &waitInfo, UINT64_MAX);
+    return;
+  }
+
+  // pick the fence under the lock, wait without it so other submitters aren't held up
+  VkFence fence = VK_NULL_HANDLE;
+  {
+    std::lock_guard<std::mutex> lock(submitMutex);
+    retireFences();
+    for (const PendingFence &pending : pendingFences) {
+      if (pending.value >= value) {
+        fence = pending.fence;
+        break;
+      }
+    }
+    if (fence == VK_NULL_HANDLE) return;
+    fenceWaiters_++;
+  }
+
+  vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
+
+  std::lock_guard<std::mutex> lock(submitMutex);
+  fenceWaiters_--;
+  retireFences();
+}
+
 void c_device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
   VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
@@ -509,8 +749,10 @@ void c_device::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
-  if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+    VkDeviceMemory &imageMemory,
+    MemoryCategory category,
+    const std::string &owner) {
+  if (vkCreateImage(device_, &imageInfo, allocator(), &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
 
@@ -522,13 +764,174 @@ void c_device::createImageWithInfo(
   allocInfo.allocationSize = memRequirements.size;
   allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
+  if (vkAllocateMemory(device_, &allocInfo, allocator(), &imageMemory) != VK_SUCCESS) {
     throw std::runtime_error("failed to allocate image memory!");
   }
+  allocationCount_.fetch_add(1, std::memory_order_relaxed);
+  memoryTracker_.onAllocate(imageMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, category, owner);
 
   if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
     throw std::runtime_error("failed to bind image memory!");
   }
 }
 
-}
\ No newline at end of file
+bool c_device::SamplerKey::operator==(const SamplerKey &o) const {
+  return std::memcmp(this, &o, sizeof(SamplerKey)) == 0;
+}
+
+size_t c_device::SamplerKeyHash::operator()(const SamplerKey &k) const {
+  // FNV-1a over the raw state, keys are zero initialised so padding is stable
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&k);
+  uint64_t h = 1469598103934665603ull;
+  for (size_t i = 0; i < sizeof(SamplerKey); i++) {
+    h ^= bytes[i];
+    h *= 1099511628211ull;
+  }
+  return size_t(h);
+}
+
+VkSampler c_device::acquireSampler(const VkSamplerCreateInfo &samplerInfo) {
+  if (samplerInfo.pNext != nullptr || samplerInfo.flags != 0) {
+    throw std::runtime_error("shared samplers don't support pNext chains or flags!");
+  }
+
+  SamplerKey key;
+  std::memset(&key, 0, sizeof(key));
+  key.magFilter = samplerInfo.magFilter;
+  key.minFilter = samplerInfo.minFilter;
+  key.mipmapMode = samplerInfo.mipmapMode;
+  key.addressModeU = samplerInfo.addressModeU;
+  key.addressModeV = samplerInfo.addressModeV;
+  key.addressModeW = samplerInfo.addressModeW;
+  key.mipLodBias = samplerInfo.mipLodBias;
+  key.anisotropyEnable = samplerInfo.anisotropyEnable;
+  key.maxAnisotropy = samplerInfo.anisotropyEnable ? samplerInfo.maxAnisotropy : 0.0f;
+  key.compareEnable = samplerInfo.compareEnable;
+  key.compareOp = samplerInfo.compareEnable ? samplerInfo.compareOp : VK_COMPARE_OP_NEVER;
+  key.minLod = samplerInfo.minLod;
+  key.maxLod = samplerInfo.maxLod;
+  key.borderColor = samplerInfo.borderColor;
+  key.unnormalizedCoordinates = samplerInfo.unnormalizedCoordinates;
+
+  std::lock_guard<std::mutex> lock(samplerMutex);
+
+  auto it = samplers.find(key);
+  if (it != samplers.end()) {
+    it->second.refs++;
+    return it->second.sampler;
+  }
+
+  VkSampler sampler;
+  if (vkCreateSampler(device_, &samplerInfo, allocator(), &sampler) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create sampler!");
+  }
+  samplers.emplace(key, SharedSampler{sampler, 1});
+  samplerKeys.emplace(sampler, key);
+  return sampler;
+}
+
+void c_device::releaseSampler(VkSampler sampler) {
+  if (sampler == VK_NULL_HANDLE) return;
+
+  std::lock_guard<std::mutex> lock(samplerMutex);
+
+  auto keyIt = samplerKeys.find(sampler);
+  if (keyIt == samplerKeys.end()) {
+    throw std::runtime_error("released a sampler that wasn't acquired from the device!");
+  }
+
+  auto it = samplers.find(keyIt->second);
+  if (--it->second.refs == 0) {
+    vkDestroySampler(device_, sampler, allocator());
+    samplers.erase(it);
+    samplerKeys.erase(keyIt);
+  }
+}
+
+std::string c_device::pipelineCachePath() const {
+  // one file per vendor/device/driver, a driver update gets a fresh cache instead of a rejected one
+  char name[96];
+  std::snprintf(name, sizeof(name), "pipeline_cache_%04x_%04x_", properties.vendorID, properties.deviceID);
+
+  std::string path = name;
+  static const char *hex = "0123456789abcdef";
+  for (uint8_t b : properties.pipelineCacheUUID) {
+    path += hex[b >> 4];
+    path += hex[b & 0xF];
+  }
+  return path + ".bin";
+}
+
+void c_device::createPipelineCache() {
+  std::vector<char> data;
+
+  std::ifstream file(pipelineCachePath(), std::ios::binary | std::ios::ate);
+  if (file.is_open()) {
+    data.resize(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), std::streamsize(data.size()));
+    if (!file) data.clear();
+  }
+
+  // the driver is supposed to reject foreign data on its own, but some don't, so check the header
+  if (!data.empty()) {
+    VkPipelineCacheHeaderVersionOne header{};
+    bool valid = data.size() >= sizeof(header);
+    if (valid) {
+      std::memcpy(&header, data.data(), sizeof(header));
+      valid = header.headerSize >= sizeof(header) && header.headerSize <= data.size() &&
+              header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+              header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+              std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+    if (!valid) {
+      std::cout << "pipeline cache: ignoring stale or corrupt " << pipelineCachePath() << std::endl;
+      data.clear();
+    }
+  }
+
+  VkPipelineCacheCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  createInfo.initialDataSize = data.size();
+  createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+  if (vkCreatePipelineCache(device_, &createInfo, allocator(), &pipelineCache_) != VK_SUCCESS) {
+    // retry empty in case the driver choked on the data
+    createInfo.initialDataSize = 0;
+    createInfo.pInitialData = nullptr;
+    data.clear();
+    if (vkCreatePipelineCache(device_, &createInfo, allocator(), &pipelineCache_) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create pipeline cache!");
+    }
+  }
+  pipelineCacheWarm_ = !data.empty();
+}
+
+void c_device::savePipelineCache() {
+  size_t size = 0;
+  if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0) return;
+
+  std::vector<char> data(size);
+  if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS) return;
+
+  // write next to the real file and rename over it, a crash mid-write can't leave a torn cache
+  const std::string path = pipelineCachePath();
+  const std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), std::streamsize(size));
+    if (!out) {
+      std::cerr << "pipeline cache: failed to write " << tmpPath << std::endl;
+      return;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmpPath, path, ec);
+  if (ec) {
+    std::cerr << "pipeline cache: failed to replace " << path << ": " << ec.message() << std::endl;
+    std::filesystem::remove(tmpPath, ec);
+  }
+}
+
+}
@@ -1,9 +1,16 @@
 #pragma once
 
+#include "deletion_queue.hpp"
+#include "host_allocator.hpp"
+#include "memory_tracker.hpp"
 #include "window.hpp"
 
 // std lib headers
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace lavander {
@@ -30,7 +37,9 @@ class c_device {
   const bool enableValidationLayers = true;
 #endif
 
-  c_device(c_window &window);
+  // window may be null for offscreen use: no surface, no present queue requirement and
+  // no swapchain extension, so it also runs on display-less drivers like lavapipe
+  explicit c_device(c_window *window);
   ~c_device();
 
   // Not copyable or movable
@@ -45,8 +54,16 @@ class c_device {
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
   VkInstance getInstance() { return instance; }
+  bool headless() const { return window == nullptr; }
   VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
 
+  // Pipeline cache shared by every pipeline (and ImGui), loaded at startup from a file
+  // keyed by the GPU and driver and written back when the device is destroyed.
+  VkPipelineCache pipelineCache() { return pipelineCache_; }
+  // true when the on-disk cache matched this device and was loaded
+  bool pipelineCacheWarm() const { return pipelineCacheWarm_; }
+  void savePipelineCache();
+
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -55,14 +72,36 @@ class c_device {
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
   // Buffer Helper Functions
+  // category and owner only label the allocation in the memory accounting
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      VkDeviceMemory &bufferMemory,
+      MemoryCategory category = MemoryCategory::Other,
+      const std::string &owner = {});
   VkCommandBuffer beginSingleTimeCommands();
+  // submits and waits for just this submission, not the whole queue
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
+
+  // Graphics queue timeline. Every submitGraphics() gets the next value of a timeline
+  // semaphore, so "is this work done" is a value comparison. Devices without timeline
+  // semaphores (pre 1.2) fall back to one fence per submission behind the same API.
+  uint64_t submitGraphics(const VkSubmitInfo &submitInfo);
+  uint64_t lastSubmittedValue() const { return submittedValue_; }
+  uint64_t completedValue();
+  bool isComplete(uint64_t value) { return value <= completedValue(); }
+  void waitForValue(uint64_t value);
+  bool timelineSupported() const { return timelineSupported_; }
+  // other queues can wait on graphics work by value, null in the fence fallback
+  VkSemaphore graphicsTimeline() { return graphicsTimeline_; }
+
+  // Destroys a GPU resource once every submission so far has completed. Safe to call
+  // any time outside command recording; callbacks run from collectDeletions().
+  void deferDestroy(std::function<void()> destroy);
+  void collectDeletions() { deletionQueue.collect(completedValue()); }
+  size_t pendingDeletions() { return deletionQueue.size(); }
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
   void copyBufferToImage(
       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
@@ -71,17 +110,74 @@ class c_device {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      VkDeviceMemory &imageMemory,
+      MemoryCategory category = MemoryCategory::Other,
+      const std::string &owner = {});
+  // frees memory from createBuffer/createImageWithInfo and drops it from the accounting
+  void freeMemory(VkDeviceMemory memory);
+
+  // live totals per heap, category and owner, plus the driver budget when available
+  MemoryTracker &memory() { return memoryTracker_; }
+  bool memoryBudgetSupported() const { return memoryBudgetSupported_; }
+
+  // Samplers are shared between everything asking for the same state. Every acquire
+  // must be paired with a release, the sampler is destroyed with its last reference.
+  VkSampler acquireSampler(const VkSamplerCreateInfo &samplerInfo);
+  void releaseSampler(VkSampler sampler);
+  size_t samplerCount() {
+    std::lock_guard<std::mutex> lock(samplerMutex);
+    return samplers.size();
+  }
+
+  // Allocation callbacks for every vkCreate*/vkDestroy* pair, tracked per allocation scope.
+  // Static so deferred destroys that only captured a VkDevice pass the same pointer.
+  static const VkAllocationCallbacks *allocator() { return HostAllocator::Get().callbacks(); }
+
+  // Running totals since startup: memory allocations made through createBuffer and
+  // createImageWithInfo, and bytes staged for upload (host visible transfer sources).
+  uint64_t allocationCount() const { return allocationCount_.load(std::memory_order_relaxed); }
+  uint64_t uploadBytes() const { return uploadBytes_.load(std::memory_order_relaxed); }
 
   VkPhysicalDeviceProperties properties;
 
  private:
+  struct SamplerKey {
+    VkFilter magFilter, minFilter;
+    VkSamplerMipmapMode mipmapMode;
+    VkSamplerAddressMode addressModeU, addressModeV, addressModeW;
+    float mipLodBias;
+    VkBool32 anisotropyEnable;
+    float maxAnisotropy;
+    VkBool32 compareEnable;
+    VkCompareOp compareOp;
+    float minLod, maxLod;
+    VkBorderColor borderColor;
+    VkBool32 unnormalizedCoordinates;
+
+    bool operator==(const SamplerKey &o) const;
+  };
+  struct SamplerKeyHash {
+    size_t operator()(const SamplerKey &k) const;
+  };
+  struct SharedSampler {
+    VkSampler sampler;
+    uint32_t refs;
+  };
+  struct PendingFence {
+    uint64_t value;
+    VkFence fence;
+  };
+
   void createInstance();
   void setupDebugMessenger();
   void createSurface();
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createPipelineCache();
+  std::string pipelineCachePath() const;
+  void createTimeline();
+  void retireFences();
 
   // helper functions
   bool isDeviceSuitable(VkPhysicalDevice device);
@@ -96,16 +192,41 @@ class c_device {
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-  c_window &window;
+  c_window *window;
   VkCommandPool commandPool;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+  bool pipelineCacheWarm_ = false;
+
+  uint32_t instanceApiVersion_ = VK_API_VERSION_1_0;
+  bool timelineSupported_ = false;
+  bool memoryBudgetSupported_ = false;
+  MemoryTracker memoryTracker_;
+  VkSemaphore graphicsTimeline_ = VK_NULL_HANDLE;
+  std::mutex submitMutex;
+  uint64_t submittedValue_ = 0;
+  uint64_t completedValue_ = 0;        // fence fallback only
+  std::deque<PendingFence> pendingFences;  // fence fallback, in submission order
+  std::vector<VkFence> freeFences;
+  // signalled fences held back from reset while another thread may still be waiting on them
+  std::vector<VkFence> retiredFences;
+  uint32_t fenceWaiters_ = 0;
+
+  DeletionQueue deletionQueue;
+
+  std::atomic<uint64_t> allocationCount_{0};
+  std::atomic<uint64_t> uploadBytes_{0};
+
+  std::mutex samplerMutex;
+  std::unordered_map<SamplerKey, SharedSampler, SamplerKeyHash> samplers;
+  std::unordered_map<VkSampler, SamplerKey> samplerKeys;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-  const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "dynamic_resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace lavander
+{
+    namespace
+    {
+        constexpr float kSmoothing = 0.1f;
+        constexpr float kStep = 0.05f;
+        //a change takes frames in flight to show up in the timings, don't chase it
+        constexpr uint32_t kSettleFrames = 30;
+        //only drop below target when over it, only go up with some headroom
+        constexpr float kHeadroom = 0.85f;
+    }
+
+    void DynamicResolution::update(float gpuMs)
+    {
+        if (gpuMs <= 0.0f) return;
+
+        smoothedMs_ = smoothedMs_ > 0.0f ? smoothedMs_ + (gpuMs - smoothedMs_) * kSmoothing : gpuMs;
+        if (!enabled || ++framesSinceChange < kSettleFrames) return;
+
+        float desired = scale_;
+        if (smoothedMs_ > targetMs)
+        {
+            desired = scale_ * std::sqrt(targetMs / smoothedMs_);
+        }
+        else if (smoothedMs_ < targetMs * kHeadroom)
+        {
+            desired = scale_ * std::sqrt(targetMs * kHeadroom / smoothedMs_);
+        }
+
+        desired = std::clamp(std::round(desired / kStep) * kStep, minScale, maxScale);
+        if (std::abs(desired - scale_) >= kStep * 0.5f)
+        {
+            scale_ = desired;
+            framesSinceChange = 0;
+        }
+    }
+}
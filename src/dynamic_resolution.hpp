@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+namespace lavander
+{
+    // Picks a render scale for the scene from measured GPU time. Shading cost goes with
+    // pixel count (scale squared), so the scale moves by the square root of budget / time,
+    // smoothed and in coarse steps so the target isn't reallocated every frame.
+    class DynamicResolution
+    {
+    public:
+        //feed the GPU time of the scene once per frame, 0 when nothing was measured
+        void update(float gpuMs);
+
+        float scale() const { return enabled ? scale_ : 1.0f; }
+        float smoothedMs() const { return smoothedMs_; }
+
+        void setEnabled(bool on) { enabled = on; }
+        bool isEnabled() const { return enabled; }
+        void setTargetMs(float ms) { targetMs = ms; }
+        float getTargetMs() const { return targetMs; }
+        void setScaleRange(float minScale, float maxScale) { this->minScale = minScale; this->maxScale = maxScale; }
+
+    private:
+        bool  enabled = true;
+        float targetMs = 10.0f;
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+
+        float scale_ = 1.0f;
+        float smoothedMs_ = 0.0f;
+        uint32_t framesSinceChange = 0;
+    };
+}
@@ -84,15 +84,33 @@ namespace lavander {
             return getStorage<T>().getAll();
         }
 
+        //drops every entity and every component of every type. Component storage is shared
+        //per type, so components holding GPU resources have to go before the device does
+        void clear()
+        {
+            entities.clear();
+            alive.clear();
+            for (auto clearStorage : storageClearers()) clearStorage();
+        }
+
     private:
         Entity nextEntityId = 1;
         std::vector<Entity> entities;
         std::unordered_set<Entity> alive;
 
+        static std::vector<void(*)()>& storageClearers()
+        {
+            static std::vector<void(*)()> clearers;
+            return clearers;
+        }
+
         template<typename T>
-        ComponentStorage<T>& getStorage() 
+        static ComponentStorage<T>& getStorage() 
         {
             static ComponentStorage<T> storage;
+            //first use registers the type with clear()
+            static const bool registered = (storageClearers().push_back([]() { getStorage<T>().getAll().clear(); }), true);
+            (void)registered;
             return storage;
         }
     };
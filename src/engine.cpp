@@ -7,45 +7,67 @@
 namespace lavander 
 {
 
-    Engine::Engine()
+    Engine::Engine(const EngineConfig& config)
+        : config(config),
+        window(config.offscreen ? nullptr : std::make_unique<c_window>(WIDTH, HEIGHT, "Engine")),
+        device(window.get()),
+        swapChain(config.offscreen ? nullptr : std::make_unique<c_swapchain>(device, window->getExtent(), config.framesInFlight))
     {
         createDescriptorSetLayout();
         createMaterialSetLayout();
-        createUniformBuffers();
-        createDescriptorPool();
-        createDescriptorSets(descriptorSetLayout);
-        createMaterialDescriptorPool();
+        frames = std::make_unique<FrameRing>(device, config.framesInFlight, sizeof(UniformBufferObject), descriptorSetLayout);
+        gpuProfiler = std::make_unique<GpuProfiler>(device, frames->depth());
+        createDescriptorAllocators();
+        textureCache = std::make_unique<TextureCache>(device, *materialDescriptors, materialSetLayout);
+        textureStreamer = std::make_unique<TextureStreamer>(device);
         createPipelineLayout();
-        createImGuiDescriptorPool();
-        initImGui();
+        if (!config.offscreen)
+        {
+            createImGuiDescriptorPool();
+            initImGui();
+        }
 
+        //offscreen frames are read back as RGBA8, on screen the target matches the swapchain
+        auto fmt = config.offscreen ? VK_FORMAT_R8G8B8A8_UNORM : swapChain->getSwapChainImageFormat();
+        auto extent = config.offscreen ? config.offscreenExtent : swapChain->getSwapChainExtent();
+        VkRenderPass scenePass = VK_NULL_HANDLE;
+        for (uint32_t i = 0; i < frames->depth(); i++)
+        {
+            auto target = std::make_unique<SceneRenderTarget>();
+            target->create(
+                device,
+                extent,
+                fmt,
+                i == 0 ? &scenePass : nullptr,
+                scenePass
+            );
+            sceneTargets.push_back(std::move(target));
+        }
+        SceneRenderTarget& sceneRT = *sceneTargets[0];
+        if (!config.offscreen) sceneView.SetSceneTexture(sceneRT.imguiTexId());
+        readbacks.resize(frames->depth());
 
-        auto fmt = swapChain.getSwapChainImageFormat();
-        sceneRT.create(
-            device.device(),
-            device.getPhysicalDevice(),
-            swapChain.getSwapChainExtent(),
-            fmt,
-            nullptr
-        );
-        sceneView.SetSceneTexture(sceneRT.imguiTexId());
+        //build every renderer pipeline up front in parallel, the renderers then just look them up
+        pipelineLibrary = std::make_unique<PipelineLibrary>(device);
+        pipelineLibrary->compileAll({
+            Renderer3D::describePipeline(sceneRT.renderPass(), pipelineLayout),
+            Renderer2D::describePipeline(sceneRT.renderPass(), pipelineLayout),
+        });
 
         renderer3D = std::make_unique<Renderer3D>(
-            device, sceneRT.renderPass(), sceneRT.extent(),
-            pipelineLayout, materialSetLayout, materialPool
+            device, *pipelineLibrary, sceneRT.renderPass(),
+            pipelineLayout, materialSetLayout, *materialDescriptors
         );
 
         renderer2D = std::make_unique<Renderer2D>(
-            device, sceneRT.renderPass(), sceneRT.extent(),
-            pipelineLayout, materialSetLayout, materialPool
+            device, *pipelineLibrary, sceneRT.renderPass(),
+            pipelineLayout, materialSetLayout, *materialDescriptors
         );
 
         sceneGraph.SetTextureLoader(
             [this](const std::string& path) -> std::shared_ptr<Texture2D>
             {
-                auto tex = std::make_shared<Texture2D>(device, path);
-                tex->allocateDescriptor(materialPool, materialSetLayout);
-                return tex;
+                return textureCache->acquire(path);
             },
             "../../src/assets"
         );
@@ -53,27 +75,179 @@ namespace lavander
         lavander::RegisterBuiltInComponents();
 
         initBuffers();
-        allocateCommandBuffers();
     }
 
     Engine::~Engine()
     {
-        shutdownImGui();
-        if (materialPool) vkDestroyDescriptorPool(device.device(), materialPool, nullptr);
-        if (materialSetLayout) vkDestroyDescriptorSetLayout(device.device(), materialSetLayout, nullptr);
-        if (descriptorSetLayout) vkDestroyDescriptorSetLayout(device.device(), descriptorSetLayout, nullptr);
-        if (pipelineLayout) vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+        //the registry outlives the device and the material descriptors, its textures and
+        //meshes have to release through them first
+        registry.clear();
+        vkDeviceWaitIdle(device.device());
+        //deferred releases can still hold ImGui textures
+        device.collectDeletions();
+        //the first target owns the shared render pass
+        for (auto it = sceneTargets.rbegin(); it != sceneTargets.rend(); ++it) (*it)->cleanup();
+        for (Readback& r : readbacks)
+        {
+            if (r.buffer) vkDestroyBuffer(device.device(), r.buffer, c_device::allocator());
+            device.freeMemory(r.memory);
+        }
+        if (!config.offscreen) shutdownImGui();
+        textureStreamer.reset();
+        textureCache.reset();
+        gpuProfiler.reset();
+        frames.reset();
+        if (materialSetLayout) vkDestroyDescriptorSetLayout(device.device(), materialSetLayout, c_device::allocator());
+        if (descriptorSetLayout) vkDestroyDescriptorSetLayout(device.device(), descriptorSetLayout, c_device::allocator());
+        if (pipelineLayout) vkDestroyPipelineLayout(device.device(), pipelineLayout, c_device::allocator());
     }
 
     void Engine::run()
     {
-        while (!window.shouldClose())
+        if (config.offscreen)
+        {
+            throw std::runtime_error("offscreen engines render through renderOffscreen()");
+        }
+
+        CpuProfiler::Get().setThreadName("Main");
+        while (!window->shouldClose())
         {
             glfwPollEvents();
             drawFrame();
+            finishFrame();
+        }
+    }
+
+    void Engine::finishFrame()
+    {
+        CpuProfiler::Get().endFrame();
+        RenderStats::Get().endFrame(frames->frameNumber(), float(CpuProfiler::Get().lastFrameMs()));
+        HostAllocator::Get().endFrame();
+        //driver budget query, a few times a second is plenty
+        if (frames->frameNumber() % 30 == 0) device.memory().refreshBudget();
+        flightRecorder.recordFrame(frames->frameNumber(), CpuProfiler::Get(), *gpuProfiler,
+            device.allocationCount(), device.uploadBytes());
+    }
+
+    void Engine::renderOffscreen(uint32_t frameCount)
+    {
+        if (!config.offscreen)
+        {
+            throw std::runtime_error("renderOffscreen() needs an offscreen engine");
+        }
+
+        for (uint32_t i = 0; i < frameCount; i++)
+        {
+            drawOffscreenFrame();
+            finishFrame();
+        }
+
+        //hand out whatever is still in flight, oldest first
+        device.waitForValue(device.lastSubmittedValue());
+        for (uint32_t i = 0; i < frames->depth(); i++)
+        {
+            deliverReadback((frames->index() + i) % frames->depth());
         }
     }
 
+    void Engine::drawOffscreenFrame()
+    {
+        PROFILE_SCOPE("Engine::drawOffscreenFrame");
+
+        //offscreen runs have no wall clock to follow, simulate at a fixed 60 Hz
+        runtime.tick(1.0f / 60.0f);
+
+        FrameContext& frame = frames->begin();
+        //the slot's previous frame finished, its pixels and timestamps are ready
+        gpuProfiler->collect(frames->index());
+        deliverReadback(frames->index());
+        materialDescriptors->beginFrame();
+
+        SceneRenderTarget& sceneRT = sceneTarget();
+        sceneView.camera().setAspect(sceneRT.extent().width / (float)sceneRT.extent().height);
+
+        textureCache->collect();
+        textureStreamer->update(registry, sceneView.camera(), float(sceneRT.extent().height));
+
+        updateUniformBuffer(frame);
+
+        VkCommandBuffer cmd = frame.commandBuffer;
+        VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(cmd, &beginInfo);
+        gpuProfiler->beginFrame(cmd, frames->index());
+        textureStreamer->record(cmd);
+        recordScenePass(frame, cmd);
+        if (config.onReadback) recordReadback(cmd);
+        vkEndCommandBuffer(cmd);
+
+        frames->submit();
+        textureStreamer->endFrame();
+        frames->advance();
+    }
+
+    void Engine::recordReadback(VkCommandBuffer cmd)
+    {
+        SceneRenderTarget& sceneRT = sceneTarget();
+        Readback& r = readbacks[frames->index()];
+        const VkExtent2D extent = sceneRT.extent();
+        const VkDeviceSize size = VkDeviceSize(extent.width) * extent.height * 4;
+
+        //this slot's last copy was delivered in begin, the buffer is free to replace
+        if (r.size < size)
+        {
+            if (r.buffer) vkDestroyBuffer(device.device(), r.buffer, c_device::allocator());
+            device.freeMemory(r.memory);
+            device.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, r.buffer, r.memory,
+                MemoryCategory::Readback, "offscreen readback");
+            vkMapMemory(device.device(), r.memory, 0, VK_WHOLE_SIZE, 0, &r.mapped);
+            r.size = size;
+        }
+
+        //chains with the pass's outgoing dependency (dst FRAGMENT_SHADER), which already made the
+        //colour writes available and did the transition to SHADER_READ_ONLY
+        VkImageMemoryBarrier toTransfer{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        toTransfer.srcAccessMask = 0;
+        toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        toTransfer.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer.image = sceneRT.image();
+        toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+        VkBufferImageCopy region{};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { extent.width, extent.height, 1 };
+        vkCmdCopyImageToBuffer(cmd, sceneRT.image(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, r.buffer, 1, &region);
+
+        VkBufferMemoryBarrier toHost{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+        toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost.buffer = r.buffer;
+        toHost.size = size;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+            0, 0, nullptr, 1, &toHost, 0, nullptr);
+
+        r.extent = extent;
+        r.frame = frames->frameNumber();
+        r.pending = true;
+    }
+
+    void Engine::deliverReadback(uint32_t slot)
+    {
+        Readback& r = readbacks[slot];
+        if (!r.pending) return;
+
+        r.pending = false;
+        if (config.onReadback) config.onReadback(r.frame, r.extent, static_cast<const uint8_t*>(r.mapped));
+    }
+
     void Engine::createPipelineLayout()
     {
         VkPushConstantRange push{};
@@ -89,7 +263,7 @@ namespace lavander
         ci.pushConstantRangeCount = 1;
         ci.pPushConstantRanges = &push;
 
-        if (vkCreatePipelineLayout(device.device(), &ci, nullptr, &pipelineLayout) != VK_SUCCESS)
+        if (vkCreatePipelineLayout(device.device(), &ci, c_device::allocator(), &pipelineLayout) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create pipeline layout");
         }
@@ -97,9 +271,9 @@ namespace lavander
 
     void Engine::createPipeline()
     {
-        auto pipelineConfig = c_pipeline::defaultPipelineConfigInfo(swapChain.width(), swapChain.height());
+        auto pipelineConfig = c_pipeline::defaultPipelineConfigInfo();
         pipelineConfig.colorBlendInfo.pAttachments = &pipelineConfig.colorBlendAttachment;
-        pipelineConfig.renderPass = swapChain.getRenderPass();
+        pipelineConfig.renderPass = sceneTarget().renderPass();
         pipelineConfig.pipelineLayout = pipelineLayout;
         pipeline = std::make_unique<c_pipeline>(
             device, 
@@ -108,63 +282,6 @@ namespace lavander
             pipelineConfig);
     }
 
-    void Engine::createCommandBuffers()
-    {
-        commandBuffers.resize(swapChain.imageCount());
-
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = device.getCommandPool();
-        allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
-
-        if(vkAllocateCommandBuffers(device.device(), &allocInfo, commandBuffers.data())!= VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate command buffers!");
-        }
-
-        for (int i = 0; i < commandBuffers.size(); i++)
-        {
-            VkCommandBufferBeginInfo beginInfo{};
-            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-            if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS)
-            {
-                throw std::runtime_error("failed to begin recording command buffers!");
-            }
-
-
-            VkClearValue sceneClears[2]{};
-            sceneClears[0].color = { 0.1f, 0.1f, 0.12f, 1.0f };
-            sceneClears[1].depthStencil = { 1.0f, 0 };
-
-            VkRenderPassBeginInfo rpScene{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-            rpScene.renderPass = sceneRT.renderPass();
-            rpScene.framebuffer = sceneRT.framebuffer();
-            rpScene.renderArea.offset = { 0,0 };
-            rpScene.renderArea.extent = sceneRT.extent();
-            rpScene.clearValueCount = 2;
-            rpScene.pClearValues = sceneClears;
-            vkCmdBeginRenderPass(commandBuffers[i], &rpScene, VK_SUBPASS_CONTENTS_INLINE);
-
-
-           // vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-            pipeline->bind(commandBuffers[i]);
-
-            vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[i], 0, nullptr);
-
-            renderer2D->draw(commandBuffers[i], registry);
-
-            vkCmdEndRenderPass(commandBuffers[i]);
-            if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
-            {
-                throw std::runtime_error("failed to record command buffer");
-            }
-
-        }
-    }
-
     void Engine::initBuffers()
     {
         std::vector<Vertex> vertices = 
@@ -184,21 +301,38 @@ namespace lavander
 
     void Engine::drawFrame()
     {
+        PROFILE_SCOPE("Engine::drawFrame");
+
         //delta time
         static double last = glfwGetTime();
         double now = glfwGetTime();
         float dt = float(now - last);
         last = now;
 
+        //simulation runs before waiting on the frame slot so it overlaps the GPU
+        runtime.tick(dt);
+
+
+        //waits until this slot's previous frame retired and recycles its resources
+        FrameContext& frame = frames->begin();
+        gpuProfiler->collect(frames->index());
 
         uint32_t imageIndex;
-        auto result = swapChain.acquireNextImage(&imageIndex);
+        auto result = swapChain->acquireNextImage(frame.imageAvailable, &imageIndex);
 
+        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            //nothing was acquired or submitted, the slot is simply reused next frame
+            recreateSwapChain();
+            return;
+        }
         if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
         {
             throw std::runtime_error("imageIndex failed to acquire swap chain image!");
         }
 
+        materialDescriptors->beginFrame();
+
         //start ImGui frame
         ImGui_ImplVulkan_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -209,36 +343,76 @@ namespace lavander
         BeginMainDockspace();
 
 
-        float swapAspect = swapChain.getSwapChainExtent().width / (float)swapChain.getSwapChainExtent().height;
-        sceneView.setSceneAspect(swapAspect);
+        //size the scene target to the panel as of last frame, scaled to the GPU budget
+        SceneRenderTarget& sceneRT = sceneTarget();
+        dynamicResolution.update(gpuProfiler->lastMs("Scene"));
+        ImVec2 panelPixels = sceneView.viewportPixelSize();
+        if (panelPixels.x >= 1.0f && panelPixels.y >= 1.0f)
+        {
+            sceneRT.fit({ uint32_t(panelPixels.x), uint32_t(panelPixels.y) }, dynamicResolution.scale());
+        }
+        sceneView.SetSceneTexture(sceneRT.imguiTexId());
+        sceneView.setSceneUvMax(sceneRT.uvMax());
+
+        float sceneAspect = sceneRT.extent().width / (float)sceneRT.extent().height;
+        sceneView.setSceneAspect(sceneAspect);
 
 
         sceneView.SetContext(&registry, sceneGraph.GetSelected());
         sceneView.OnImGuiRender();
         sceneGraph.OnImGuiRender();
+        gpuProfiler->OnImGuiRender();
+        CpuProfiler::Get().OnImGuiRender();
+        device.memory().OnImGuiRender();
+        HostAllocator::Get().OnImGuiRender();
 
         //camera
         if (sceneView.isHovered())
         {
-            sceneView.camera().update(window.getGLFWwindow(), dt);
+            sceneView.camera().update(window->getGLFWwindow(), dt);
         }
 
         ImVec2 vp = sceneGraph.getSceneViewportSize();
         if (vp.x > 0 && vp.y > 0) setSceneViewport(vp.x, vp.y);
 
-        sceneView.SetSceneTexture(sceneRT.imguiTexId());
         ImGui::Render(); // finalize ImGui draw data for this frame
 
-        updateUniformBuffer(imageIndex);
-        recordCommandBuffer(imageIndex);
+        textureCache->collect();
+        textureStreamer->update(registry, sceneView.camera(), float(sceneRT.extent().height));
+        pipelineLibrary->endFrame(dt * 1000.0f);
+
+        updateUniformBuffer(frame);
+        recordCommandBuffer(frame, imageIndex);
 
-        result = swapChain.submitCommandBuffers(&commandBuffers[imageIndex], &imageIndex);
-        if (result != VK_SUCCESS)
+        frames->submit(swapChain->renderFinished(imageIndex));
+        textureStreamer->endFrame();
+        result = swapChain->present(imageIndex);
+        frames->advance();
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window->wasWindowResized())
+        {
+            recreateSwapChain();
+        }
+        else if (result != VK_SUCCESS)
         {
             throw std::runtime_error("result failed to acquire swap chain image!");
         }
     }
 
+    void Engine::recreateSwapChain()
+    {
+        //minimized, nothing to present to until the window has an area again
+        VkExtent2D extent = window->getExtent();
+        while (extent.width == 0 || extent.height == 0)
+        {
+            if (window->shouldClose()) return;
+            glfwWaitEvents();
+            extent = window->getExtent();
+        }
+
+        window->resetWindowResizedFlag();
+        swapChain->recreate(extent);
+    }
+
     void Engine::createDescriptorSetLayout()
     {
         VkDescriptorSetLayoutBinding uboLayoutBinding{};
@@ -253,85 +427,13 @@ namespace lavander
         layoutInfo.bindingCount = 1;
         layoutInfo.pBindings = &uboLayoutBinding;
 
-        if (vkCreateDescriptorSetLayout(device.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) 
+        if (vkCreateDescriptorSetLayout(device.device(), &layoutInfo, c_device::allocator(), &descriptorSetLayout) != VK_SUCCESS) 
         {
             throw std::runtime_error("failed to create descriptor set layout!");
         }
     }
 
-    void Engine::createUniformBuffers()
-    {
-        VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-        size_t imageCount = swapChain.imageCount();
-        uniformBuffers.resize(imageCount);
-        uniformBuffersMemory.resize(imageCount);
-
-        for (size_t i = 0; i < imageCount; i++)
-        {
-            device.createBuffer(
-                bufferSize,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                uniformBuffers[i],
-                uniformBuffersMemory[i]);
-        }
-    }
-    void Engine::createDescriptorPool()
-    {
-        VkDescriptorPoolSize poolSize{};
-        poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        poolSize.descriptorCount = static_cast<uint32_t>(swapChain.imageCount());
-
-        VkDescriptorPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.poolSizeCount = 1;
-        poolInfo.pPoolSizes = &poolSize;
-        poolInfo.maxSets = static_cast<uint32_t>(swapChain.imageCount());
-
-        if (vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to create descriptor pool!");
-        }
-    }
-    void Engine::createDescriptorSets(VkDescriptorSetLayout descriptorSetLayout)
-    {
-        std::vector<VkDescriptorSetLayout> layouts(swapChain.imageCount(), descriptorSetLayout);
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = descriptorPool;
-        allocInfo.descriptorSetCount = static_cast<uint32_t>(swapChain.imageCount());
-        allocInfo.pSetLayouts = layouts.data();
-
-        descriptorSets.resize(swapChain.imageCount());
-
-        if (vkAllocateDescriptorSets(device.device(), &allocInfo, descriptorSets.data()) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate descriptor sets!");
-        }
-
-        for (size_t i = 0; i < swapChain.imageCount(); i++)
-        {
-            VkDescriptorBufferInfo bufferInfo{};
-            bufferInfo.buffer = uniformBuffers[i];
-            bufferInfo.offset = 0;
-            bufferInfo.range = sizeof(UniformBufferObject);
-
-            VkWriteDescriptorSet descriptorWrite{};
-            descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrite.dstSet = descriptorSets[i];
-            descriptorWrite.dstBinding = 0;
-            descriptorWrite.dstArrayElement = 0;
-            descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrite.descriptorCount = 1;
-            descriptorWrite.pBufferInfo = &bufferInfo;
-
-            vkUpdateDescriptorSets(device.device(), 1, &descriptorWrite, 0, nullptr);
-        }
-
-    }
-
-    void Engine::updateUniformBuffer(uint32_t currentImage)
+    void Engine::updateUniformBuffer(FrameContext& frame)
     {
         UniformBufferObject ubo{};
         auto& cam = sceneView.camera();
@@ -347,60 +449,31 @@ namespace lavander
       //  ubo.proj = glm::ortho(-aspect, aspect, -1.0f, 1.0f);
        // ubo.proj[1][1] *= -1.0f;
 
-        void* data = nullptr;
-        vkMapMemory(device.device(), uniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
-        std::memcpy(data, &ubo, sizeof(ubo));
-        vkUnmapMemory(device.device(), uniformBuffersMemory[currentImage]);
+        //this frame's slice, nothing in flight reads it anymore
+        std::memcpy(frame.uboMapped, &ubo, sizeof(ubo));
+        RenderStats::Get().countBufferUpload(sizeof(ubo));
     }
 
-    void Engine::allocateCommandBuffers() 
+    void Engine::recordCommandBuffer(FrameContext& frame, uint32_t idx) 
     {
-        commandBuffers.resize(swapChain.imageCount());
+        PROFILE_SCOPE("Engine::recordCommandBuffer");
 
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = device.getCommandPool();
-        allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
-
-        if (vkAllocateCommandBuffers(device.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate command buffers!");
-        }
-    }
-
-    void Engine::recordCommandBuffer(int idx) 
-    {
-        auto cmd = commandBuffers[idx];
-        vkResetCommandBuffer(cmd, 0);
+        //the frame's pool was reset when the frame began
+        auto cmd = frame.commandBuffer;
         VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
         vkBeginCommandBuffer(cmd, &beginInfo);
+        gpuProfiler->beginFrame(cmd, frames->index());
+        textureStreamer->record(cmd);
 
-        //offscreen pass
-        VkClearValue sceneClear{};
-        sceneClear.color = { 0.1f, 0.1f, 0.12f, 1.0f };
-        VkRenderPassBeginInfo rpScene{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-        rpScene.renderPass = sceneRT.renderPass();
-        rpScene.framebuffer = sceneRT.framebuffer();
-        rpScene.renderArea.offset = { 0,0 };
-        rpScene.renderArea.extent = sceneRT.extent();
-        rpScene.clearValueCount = 1;
-        rpScene.pClearValues = &sceneClear;
-        vkCmdBeginRenderPass(cmd, &rpScene, VK_SUBPASS_CONTENTS_INLINE);
-
-        //pipeline->bind(cmd);
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, descriptorSets.data() + idx, 0, nullptr);
-
-        renderer3D->draw(cmd, registry);
-        renderer2D->draw(cmd, registry);
-
-        vkCmdEndRenderPass(cmd);
+        recordScenePass(frame, cmd);
 
         //swapchain pass for imgui only
+        uint32_t compositeScope = gpuProfiler->beginScope(cmd, "ImGui composite");
         VkRenderPassBeginInfo rpMain{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-        rpMain.renderPass = swapChain.getRenderPass();
-        rpMain.framebuffer = swapChain.getFrameBuffer(idx);
-        rpMain.renderArea = { {0,0}, swapChain.getSwapChainExtent() };
+        rpMain.renderPass = swapChain->getRenderPass();
+        rpMain.framebuffer = swapChain->getFrameBuffer(idx);
+        rpMain.renderArea = { {0,0}, swapChain->getSwapChainExtent() };
 
         std::array<VkClearValue, 2> clears{};
         clears[0].color = { 0.2f,0.5f,0.9f,1.0f };
@@ -414,9 +487,51 @@ namespace lavander
         ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd);
 
         vkCmdEndRenderPass(cmd);
+        gpuProfiler->endScope(cmd, compositeScope);
         vkEndCommandBuffer(cmd);
     }
 
+    void Engine::recordScenePass(FrameContext& frame, VkCommandBuffer cmd)
+    {
+        //offscreen pass, into this frame's own target
+        SceneRenderTarget& sceneRT = sceneTarget();
+        std::array<VkClearValue, 2> sceneClears{};
+        sceneClears[0].color = { 0.1f, 0.1f, 0.12f, 1.0f };
+        sceneClears[1].depthStencil = { 1.0f, 0 };
+        VkRenderPassBeginInfo rpScene{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+        rpScene.renderPass = sceneRT.renderPass();
+        rpScene.framebuffer = sceneRT.framebuffer();
+        rpScene.renderArea.offset = { 0,0 };
+        rpScene.renderArea.extent = sceneRT.extent();
+        rpScene.clearValueCount = (uint32_t)sceneClears.size();
+        rpScene.pClearValues = sceneClears.data();
+
+        uint32_t sceneScope = gpuProfiler->beginScope(cmd, "Scene");
+        vkCmdBeginRenderPass(cmd, &rpScene, VK_SUBPASS_CONTENTS_INLINE);
+
+        //pipelines keep viewport/scissor dynamic, so a resized target needs no recompiles
+        VkViewport viewport{ 0.0f, 0.0f, float(sceneRT.extent().width), float(sceneRT.extent().height), 0.0f, 1.0f };
+        VkRect2D scissor{ {0, 0}, sceneRT.extent() };
+        vkCmdSetViewport(cmd, 0, 1, &viewport);
+        vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+        //pipeline->bind(cmd);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.globalSet, 0, nullptr);
+        RenderStats::Get().countDescriptorBind();
+
+        {
+            GpuScope scope(*gpuProfiler, cmd, "Renderer3D");
+            renderer3D->draw(cmd, registry);
+        }
+        {
+            GpuScope scope(*gpuProfiler, cmd, "Renderer2D");
+            renderer2D->draw(cmd, registry);
+        }
+
+        vkCmdEndRenderPass(cmd);
+        gpuProfiler->endScope(cmd, sceneScope);
+    }
+
     void Engine::createMaterialSetLayout()
     {
         VkDescriptorSetLayoutBinding sampler{};
@@ -428,27 +543,18 @@ namespace lavander
         VkDescriptorSetLayoutCreateInfo info{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
         info.bindingCount = 1;
         info.pBindings = &sampler;
-        if (vkCreateDescriptorSetLayout(device.device(), &info, nullptr, &materialSetLayout) != VK_SUCCESS)
+        if (vkCreateDescriptorSetLayout(device.device(), &info, c_device::allocator(), &materialSetLayout) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create material set layout");
         }
     }
 
-    void Engine::createMaterialDescriptorPool(uint32_t maxSets)
+    void Engine::createDescriptorAllocators()
     {
-        VkDescriptorPoolSize size{};
-        size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        size.descriptorCount = maxSets;
-
-        VkDescriptorPoolCreateInfo ci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-        ci.poolSizeCount = 1;
-        ci.pPoolSizes = &size;
-        ci.maxSets = maxSets;
-
-        if (vkCreateDescriptorPool(device.device(), &ci, nullptr, &materialPool) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to create material descriptor pool");
-        }
+        //material sets are one combined image sampler each
+        std::vector<DescriptorAllocator::PoolRatio> materialRatios = { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f } };
+        materialDescriptors = std::make_unique<DescriptorAllocator>(
+            device, DescriptorAllocator::Mode::Persistent, frames->depth(), materialRatios, 512);
     }
 
     void Engine::createImGuiDescriptorPool()
@@ -476,7 +582,7 @@ namespace lavander
         pool_info.poolSizeCount = (uint32_t)pool_sizes.size();
         pool_info.pPoolSizes = pool_sizes.data();
 
-        if (vkCreateDescriptorPool(device.device(), &pool_info, nullptr, &imguiPool) != VK_SUCCESS)
+        if (vkCreateDescriptorPool(device.device(), &pool_info, c_device::allocator(), &imguiPool) != VK_SUCCESS)
         {
             throw std::runtime_error("Failed to create ImGui descriptor pool");
         }
@@ -502,7 +608,7 @@ namespace lavander
         // io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
 
         //GLFW backend
-        ImGui_ImplGlfw_InitForVulkan(window.getGLFWwindow(), true);
+        ImGui_ImplGlfw_InitForVulkan(window->getGLFWwindow(), true);
 
         //vulkan backend
         ImGui_ImplVulkan_InitInfo init_info{};
@@ -512,12 +618,14 @@ namespace lavander
         init_info.QueueFamily = device.findPhysicalQueueFamilies().graphicsFamily;
         init_info.Queue = device.graphicsQueue();
         init_info.DescriptorPool = imguiPool;
-        init_info.MinImageCount = std::max<uint32_t>(2, swapChain.imageCount());
-        init_info.ImageCount = swapChain.imageCount();
+        init_info.PipelineCache = device.pipelineCache();
+        init_info.MinImageCount = std::max<uint32_t>(2, swapChain->imageCount());
+        init_info.ImageCount = std::max<uint32_t>(uint32_t(swapChain->imageCount()), frames->depth());
         init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
         init_info.CheckVkResultFn = CheckVk;
+        init_info.Allocator = c_device::allocator();
 
-        init_info.RenderPass = swapChain.getRenderPass();
+        init_info.RenderPass = swapChain->getRenderPass();
 
 
         //imgui expects to manually load vulkan function pointers before the init, so here we do that if no prototypes is set
@@ -572,7 +680,7 @@ namespace lavander
                 if (ImGui::MenuItem("Open...", "Ctrl+O")) { /* TODO */ }
                 if (ImGui::MenuItem("Save", "Ctrl+S")) { /* TODO */ }
                 ImGui::Separator();
-                if (ImGui::MenuItem("Exit")) { glfwSetWindowShouldClose(window.getGLFWwindow(), 1); }
+                if (ImGui::MenuItem("Exit")) { glfwSetWindowShouldClose(window->getGLFWwindow(), 1); }
                 ImGui::EndMenu();
             }
             if (ImGui::BeginMenu("Edit"))
@@ -584,6 +692,7 @@ namespace lavander
             if (ImGui::BeginMenu("View"))
             {
                 if (ImGui::MenuItem("Reset Layout")) { ImGui::DockBuilderRemoveNode(ImGui::GetID("MainDockSpace")); }
+                if (ImGui::MenuItem("Dump Flight Recording")) { flightRecorder.dump("requested from the editor"); }
                 ImGui::EndMenu();
             }
             if (ImGui::BeginMenu("Help"))
@@ -618,6 +727,10 @@ namespace lavander
             //ensure to make the name the same as the window otherwise things fails
             ImGui::DockBuilderDockWindow("Scene", dock_left);
             ImGui::DockBuilderDockWindow("Properties", dock_right);
+            ImGui::DockBuilderDockWindow("CPU Profiler", dock_right);
+            ImGui::DockBuilderDockWindow("GPU Profiler", dock_right);
+            ImGui::DockBuilderDockWindow("Memory", dock_right);
+            ImGui::DockBuilderDockWindow("Driver Allocations", dock_right);
 
             ImGui::DockBuilderFinish(dockspace_id);
         }
@@ -632,7 +745,7 @@ namespace lavander
         ImGui::DestroyContext();
         if (imguiPool) 
         {
-            vkDestroyDescriptorPool(device.device(), imguiPool, nullptr);
+            vkDestroyDescriptorPool(device.device(), imguiPool, c_device::allocator());
             imguiPool = VK_NULL_HANDLE;
         }
     }
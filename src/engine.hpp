@@ -2,14 +2,26 @@
 
 #include "window.hpp"
 #include "pipeline.hpp"
+#include "pipeline_library.hpp"
 #include "device.hpp"
 #include "swap_chain.hpp"
 #include "buffers.hpp"
 #include "ecs_registry.hpp"
+#include "runtime.hpp"
 #include "renderer_2d.hpp"
 #include "renderer_3d.hpp"
 #include "scene_graph.hpp"
-
+#include "texture_cache.hpp"
+#include "texture_streamer.hpp"
+#include "descriptor_allocator.hpp"
+#include "frame_context.hpp"
+#include "dynamic_resolution.hpp"
+#include "gpu_profiler.hpp"
+#include "cpu_profiler.hpp"
+#include "flight_recorder.hpp"
+#include "render_stats.hpp"
+
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -28,71 +40,127 @@
 
 namespace lavander 
 {
+    struct EngineConfig
+    {
+        //1-3, more overlaps CPU and GPU further at the cost of latency
+        uint32_t framesInFlight = 2;
+
+        //no window, surface, swapchain or ImGui; the scene renders into its target only
+        bool offscreen = false;
+        VkExtent2D offscreenExtent{ 1280, 720 };
+
+        //offscreen only: receives each finished frame as tightly packed RGBA8 rows once the GPU
+        //is done with it. Leave empty to discard frames.
+        std::function<void(uint64_t frame, VkExtent2D extent, const uint8_t* pixels)> onReadback;
+    };
+
     class Engine 
     {
         public:
         static constexpr int WIDTH = 1280;
         static constexpr int HEIGHT = 720;
         
-        Engine();
+        explicit Engine(const EngineConfig& config = {});
         ~Engine();
 
         Engine(const Engine&) = delete;
         Engine&operator=(const Engine&) = delete;
         
         void run();
+        //offscreen mode: renders frameCount frames and waits until every readback was delivered
+        void renderOffscreen(uint32_t frameCount);
+        bool isOffscreen() const { return config.offscreen; }
 
         ECSRegistry& getRegistry() { return registry; }
+        //simulation systems, ticked once per frame before rendering
+        Runtime& getRuntime() { return runtime; }
 
+        private:
+        //declared ahead of the scene graph, which points at its registry
+        Runtime runtime;
+        ECSRegistry& registry = runtime.registry();
+
+        public:
         SceneGraph sceneGraph{ &registry };
         SceneViewPanel sceneView;
-        SceneRenderTarget sceneRT;
+        //the target the current frame renders and composites, one per frame in flight
+        SceneRenderTarget& sceneTarget() { return *sceneTargets[frames->index()]; }
         VkDescriptorSetLayout getMaterialSetLayout() const { return materialSetLayout; }
-        VkDescriptorPool      getMaterialDescriptorPool() const { return materialPool; }
+        DescriptorAllocator&  getMaterialDescriptors() { return *materialDescriptors; }
+        DescriptorAllocator&  getFrameDescriptors() { return *frames->current().descriptors; }
+        FrameRing&            getFrames() { return *frames; }
 
         c_device& getDevice() { return device; }
+        TextureCache& getTextureCache() { return *textureCache; }
+        TextureStreamer& getTextureStreamer() { return *textureStreamer; }
+        PipelineLibrary& getPipelineLibrary() { return *pipelineLibrary; }
+        DynamicResolution& getDynamicResolution() { return dynamicResolution; }
+        GpuProfiler& getGpuProfiler() { return *gpuProfiler; }
+        FlightRecorder& getFlightRecorder() { return flightRecorder; }
+        MemoryTracker& getMemoryTracker() { return device.memory(); }
 
         void setSceneViewport(float w, float h) { sceneViewW = w; sceneViewH = h; }
 
         private:
         void createPipelineLayout();
         void createPipeline();
-        void createCommandBuffers();
         void initBuffers();
         void drawFrame();
+        void drawOffscreenFrame();
+        //closes the frame for the CPU profiler and flight recorder
+        void finishFrame();
+        void recreateSwapChain();
         void createDescriptorSetLayout();
-        void createUniformBuffers();
-        void createDescriptorPool();
-        void createDescriptorSets(VkDescriptorSetLayout descriptorSetLayout);
-        void updateUniformBuffer(uint32_t currentImage);
+        void updateUniformBuffer(FrameContext& frame);
 
-        void allocateCommandBuffers();
-        void recordCommandBuffer(int imageIndex);
+        void recordCommandBuffer(FrameContext& frame, uint32_t imageIndex);
+        void recordScenePass(FrameContext& frame, VkCommandBuffer cmd);
+        void recordReadback(VkCommandBuffer cmd);
+        void deliverReadback(uint32_t slot);
         void createMaterialSetLayout();
-        void Engine::createMaterialDescriptorPool(uint32_t maxSets = 512);
+        void createDescriptorAllocators();
 
 
-        c_window window{WIDTH, HEIGHT, "Engine"};
-        c_device device{window};
-        c_swapchain swapChain{device, window.getExtent()};
+        EngineConfig config;
+        //window and swapchain are null offscreen
+        std::unique_ptr<c_window> window;
+        c_device device;
+        std::unique_ptr<c_swapchain> swapChain;
         std::unique_ptr<c_pipeline> pipeline;
+        std::unique_ptr<PipelineLibrary> pipelineLibrary;
         VkPipelineLayout pipelineLayout;
-        std::vector<VkCommandBuffer> commandBuffers;
 
         std::unique_ptr<c_buffers> buffers;
 
         VkDescriptorSetLayout descriptorSetLayout;
 
         VkDescriptorSetLayout materialSetLayout{};
-        VkDescriptorPool      materialPool{};
-
-        VkDescriptorPool descriptorPool;
-        std::vector<VkDescriptorSet> descriptorSets;
-
-        std::vector<VkBuffer> uniformBuffers;
-        std::vector<VkDeviceMemory> uniformBuffersMemory;
+        //long lived material sets, the transient ones live in each FrameContext
+        std::unique_ptr<DescriptorAllocator> materialDescriptors;
+        std::unique_ptr<TextureCache> textureCache;
+        std::unique_ptr<TextureStreamer> textureStreamer;
+
+        //per frame in flight command buffer, sync, UBO slice and global set
+        std::unique_ptr<FrameRing> frames;
+        std::unique_ptr<GpuProfiler> gpuProfiler;
+        FlightRecorder flightRecorder;
+        DynamicResolution dynamicResolution;
+        //so a frame's scene pass never waits on the previous frame's composite reading it
+        std::vector<std::unique_ptr<SceneRenderTarget>> sceneTargets;
+
+        //offscreen copies of each slot's scene target, handed out when the slot comes back
+        struct Readback
+        {
+            VkBuffer       buffer = VK_NULL_HANDLE;
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            void*          mapped = nullptr;
+            VkDeviceSize   size = 0;
+            VkExtent2D     extent{};
+            uint64_t       frame = 0;
+            bool           pending = false;
+        };
+        std::vector<Readback> readbacks;
 
-        ECSRegistry registry;
         std::unique_ptr<Renderer2D> renderer2D;
         std::unique_ptr<Renderer3D> renderer3D;
         
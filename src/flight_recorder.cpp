@@ -0,0 +1,200 @@
+#include "flight_recorder.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace lavander
+{
+    FlightRecorder::FlightRecorder(const Settings& settings)
+        : settings_(settings)
+    {
+        //everything is allocated up front, recording a frame only reuses capacity
+        ring.resize(std::max(1u, settings_.maxFrames));
+        for (FrameRecord& record : ring)
+        {
+            record.cpu.reserve(settings_.maxEventsPerFrame);
+            record.gpu.reserve(16);
+        }
+    }
+
+    FlightRecorder::~FlightRecorder()
+    {
+        if (writer.joinable()) writer.join();
+    }
+
+    uint16_t FlightRecorder::threadIndex(const std::string& name)
+    {
+        auto it = std::find(threadNames.begin(), threadNames.end(), name);
+        if (it != threadNames.end()) return uint16_t(it - threadNames.begin());
+
+        threadNames.push_back(name);
+        return uint16_t(threadNames.size() - 1);
+    }
+
+    void FlightRecorder::recordFrame(uint64_t frameNumber, const CpuProfiler& cpu, const GpuProfiler& gpu,
+        uint64_t totalAllocations, uint64_t totalUploadBytes)
+    {
+        if (!enabled) return;
+
+        FrameRecord& record = ring[next];
+        next = (next + 1) % uint32_t(ring.size());
+        count = std::min(count + 1, uint32_t(ring.size()));
+
+        record.frame = frameNumber;
+        record.beginNs = cpu.lastFrameBeginNs();
+        record.endNs = record.beginNs + int64_t(cpu.lastFrameMs() * 1e6);
+        record.allocations = totalAllocations - lastAllocations;
+        record.uploadBytes = totalUploadBytes - lastUploadBytes;
+        lastAllocations = totalAllocations;
+        lastUploadBytes = totalUploadBytes;
+
+        record.cpu.clear();
+        record.droppedEvents = 0;
+        for (const CpuProfiler::ThreadFrame& thread : cpu.lastFrame())
+        {
+            uint16_t index = threadIndex(thread.name);
+            for (const CpuProfiler::Event& e : thread.events)
+            {
+                if (record.cpu.size() >= settings_.maxEventsPerFrame)
+                {
+                    record.droppedEvents++;
+                    continue;
+                }
+                record.cpu.push_back({ e.name, e.beginNs, e.endNs, index, uint16_t(e.depth) });
+            }
+        }
+
+        //GPU times are from the newest retired frame, a few frames behind this one
+        record.gpu.clear();
+        const auto& scopes = gpu.scopes();
+        for (size_t i = 0; i < scopes.size(); i++)
+        {
+            if (i >= gpuNames.size()) gpuNames.push_back(scopes[i].name);
+            if (scopes[i].samples) record.gpu.push_back({ uint16_t(i), scopes[i].lastMs });
+        }
+
+        //one dump per window, a burst of hitches lands in the first file
+        double frameMs = double(record.endNs - record.beginNs) * 1e-6;
+        if (frameMs > settings_.hitchMs && record.endNs - lastDumpNs > int64_t(settings_.windowSeconds * 1e9))
+        {
+            char reason[64];
+            std::snprintf(reason, sizeof(reason), "frame %llu took %.1f ms", (unsigned long long)frameNumber, frameMs);
+            dump(reason);
+        }
+    }
+
+    std::string FlightRecorder::dump(const char* reason)
+    {
+        if (count == 0 || writing.load()) return {};
+        if (writer.joinable()) writer.join();
+
+        //oldest first, only what falls into the window
+        const FrameRecord& newest = ring[(next + ring.size() - 1) % ring.size()];
+        int64_t windowBegin = newest.endNs - int64_t(settings_.windowSeconds * 1e9);
+
+        std::vector<FrameRecord> frames;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const FrameRecord& record = ring[(next + ring.size() - count + i) % ring.size()];
+            if (record.endNs >= windowBegin) frames.push_back(record);
+        }
+
+        lastDumpNs = newest.endNs;
+        dumpCount_++;
+
+        std::error_code ec;
+        std::filesystem::create_directories(settings_.directory, ec);
+        std::string path = (std::filesystem::path(settings_.directory) /
+            ("hitch_frame_" + std::to_string(newest.frame) + ".json")).string();
+
+        //formatting megabytes of JSON would be a hitch of its own
+        writing = true;
+        writer = std::thread([this, path, why = std::string(reason), frames = std::move(frames),
+            threads = threadNames, gpus = gpuNames]() mutable
+            {
+                write(path, why, std::move(frames), std::move(threads), std::move(gpus));
+                writing = false;
+            });
+
+        std::cout << "flight recorder: " << reason << ", writing " << path << std::endl;
+        return path;
+    }
+
+    namespace
+    {
+        void writeString(std::ostream& out, const std::string& s)
+        {
+            out << '"';
+            for (char c : s)
+            {
+                if (c == '"' || c == '\\') out << '\\' << c;
+                else if (uint8_t(c) < 0x20) out << ' ';
+                else out << c;
+            }
+            out << '"';
+        }
+    }
+
+    void FlightRecorder::write(const std::string& path, const std::string& reason, std::vector<FrameRecord> frames,
+        std::vector<std::string> threadNames, std::vector<std::string> gpuNames)
+    {
+        std::ofstream out(path);
+        if (!out || frames.empty()) return;
+
+        //trace timestamps are microseconds from the first frame in the window
+        const int64_t origin = frames.front().beginNs;
+        auto us = [origin](int64_t ns) { return double(ns - origin) * 1e-3; };
+        //default precision is 6 significant digits, a few seconds in that rounds to ~10 us and
+        //children start before their parents; fixed keeps every event at ns resolution
+        out << std::fixed << std::setprecision(3);
+
+        //tid 0 carries the frames, CPU threads follow
+        const int framesTid = 0;
+        out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"reason\":";
+        writeString(out, reason);
+        out << "},\"traceEvents\":[\n";
+
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << framesTid << ",\"args\":{\"name\":\"Frames\"}}";
+        for (size_t t = 0; t < threadNames.size(); t++)
+        {
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t + 1 << ",\"args\":{\"name\":";
+            writeString(out, threadNames[t]);
+            out << "}}";
+        }
+
+        for (const FrameRecord& f : frames)
+        {
+            out << ",\n{\"name\":\"Frame " << f.frame << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << framesTid
+                << ",\"ts\":" << us(f.beginNs) << ",\"dur\":" << double(f.endNs - f.beginNs) * 1e-3
+                << ",\"args\":{\"droppedEvents\":" << f.droppedEvents << "}}";
+
+            for (const CpuEvent& e : f.cpu)
+            {
+                out << ",\n{\"name\":";
+                writeString(out, e.name);
+                out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread + 1 << ",\"ts\":" << us(e.beginNs)
+                    << ",\"dur\":" << double(e.endNs - e.beginNs) * 1e-3 << "}";
+            }
+
+            out << ",\n{\"name\":\"GPU ms\",\"ph\":\"C\",\"pid\":1,\"ts\":" << us(f.endNs) << ",\"args\":{";
+            for (size_t i = 0; i < f.gpu.size(); i++)
+            {
+                if (i) out << ',';
+                writeString(out, gpuNames[f.gpu[i].scope]);
+                out << ':' << f.gpu[i].ms;
+            }
+            out << "}}";
+
+            out << ",\n{\"name\":\"Allocations\",\"ph\":\"C\",\"pid\":1,\"ts\":" << us(f.endNs)
+                << ",\"args\":{\"count\":" << f.allocations << "}}";
+            out << ",\n{\"name\":\"Uploads KB\",\"ph\":\"C\",\"pid\":1,\"ts\":" << us(f.endNs)
+                << ",\"args\":{\"KB\":" << double(f.uploadBytes) / 1024.0 << "}}";
+        }
+
+        out << "\n]}\n";
+    }
+}
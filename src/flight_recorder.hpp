@@ -0,0 +1,100 @@
+#pragma once
+#include "cpu_profiler.hpp"
+#include "gpu_profiler.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lavander
+{
+    // Keeps the last few seconds of frames (CPU scopes, GPU pass times, allocation and
+    // upload counts) in a fixed ring and writes them out as a Chrome trace-event JSON
+    // whenever a frame takes longer than the hitch threshold. Open the file in
+    // chrome://tracing or ui.perfetto.dev. Memory is fixed at construction.
+    class FlightRecorder
+    {
+    public:
+        struct Settings
+        {
+            float hitchMs = 50.0f;          // slower frames trigger a dump
+            float windowSeconds = 5.0f;     // how far back a dump reaches
+            uint32_t maxFrames = 600;       // ring size, 10 s at 60 Hz
+            uint32_t maxEventsPerFrame = 256; // CPU scopes kept per frame, the rest are counted
+            std::string directory = "traces";
+        };
+
+        FlightRecorder() : FlightRecorder(Settings{}) {}
+        explicit FlightRecorder(const Settings& settings);
+        ~FlightRecorder();
+
+        FlightRecorder(const FlightRecorder&) = delete;
+        FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+        //call once per frame after CpuProfiler::endFrame, counters are running totals
+        void recordFrame(uint64_t frameNumber, const CpuProfiler& cpu, const GpuProfiler& gpu,
+            uint64_t totalAllocations, uint64_t totalUploadBytes);
+
+        //writes the window ending at the newest frame on a background thread, returns the
+        //file name or an empty string while the previous dump is still being written
+        std::string dump(const char* reason);
+
+        void setEnabled(bool on) { enabled = on; }
+        bool isEnabled() const { return enabled; }
+        const Settings& settings() const { return settings_; }
+        void setHitchMs(float ms) { settings_.hitchMs = ms; }
+        uint32_t dumpCount() const { return dumpCount_; }
+
+    private:
+        struct CpuEvent
+        {
+            const char* name;
+            int64_t  beginNs;
+            int64_t  endNs;
+            uint16_t thread; // index into threadNames
+            uint16_t depth;
+        };
+
+        struct GpuSample
+        {
+            uint16_t scope; // index into gpuNames
+            float    ms;
+        };
+
+        struct FrameRecord
+        {
+            uint64_t frame = 0;
+            int64_t  beginNs = 0;
+            int64_t  endNs = 0;
+            uint64_t allocations = 0;
+            uint64_t uploadBytes = 0;
+            uint32_t droppedEvents = 0;
+            std::vector<CpuEvent> cpu;
+            std::vector<GpuSample> gpu;
+        };
+
+        uint16_t threadIndex(const std::string& name);
+        static void write(const std::string& path, const std::string& reason, std::vector<FrameRecord> frames,
+            std::vector<std::string> threadNames, std::vector<std::string> gpuNames);
+
+        Settings settings_;
+        bool enabled = true;
+
+        std::vector<FrameRecord> ring;
+        uint32_t next = 0;
+        uint32_t count = 0;
+
+        std::vector<std::string> threadNames;
+        std::vector<std::string> gpuNames;
+
+        uint64_t lastAllocations = 0;
+        uint64_t lastUploadBytes = 0;
+        int64_t  lastDumpNs = 0;
+        uint32_t dumpCount_ = 0;
+
+        std::thread writer;
+        std::atomic<bool> writing{ false };
+    };
+}
@@ -0,0 +1,155 @@
+#include "frame_context.hpp"
+#include "cpu_profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace lavander
+{
+    FrameRing::FrameRing(c_device& device, uint32_t depth, VkDeviceSize uboSize, VkDescriptorSetLayout globalLayout)
+        : device(device), uboSize(uboSize), globalLayout(globalLayout)
+    {
+        depth = std::clamp(depth, 1u, kMaxDepth);
+        frames.resize(depth);
+
+        VkDevice dev = device.device();
+
+        for (FrameContext& frame : frames)
+        {
+            VkCommandPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily;
+            if (vkCreateCommandPool(dev, &poolInfo, c_device::allocator(), &frame.commandPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create frame command pool!");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+            allocInfo.commandPool = frame.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(dev, &allocInfo, &frame.commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate frame command buffer!");
+            }
+
+            //the swapchain only takes binary semaphores, retirement goes through the device timeline
+            VkSemaphoreCreateInfo semaphoreInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+            if (vkCreateSemaphore(dev, &semaphoreInfo, c_device::allocator(), &frame.imageAvailable) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create frame synchronization objects!");
+            }
+
+            //per frame sets are mostly the global UBO set, small pools are plenty
+            std::vector<DescriptorAllocator::PoolRatio> ratios = { { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f } };
+            frame.descriptors = std::make_unique<DescriptorAllocator>(device, DescriptorAllocator::Mode::Transient, depth, ratios, 16);
+        }
+
+        createUniformBuffer(uboSize);
+    }
+
+    FrameRing::~FrameRing()
+    {
+        VkDevice dev = device.device();
+        vkDeviceWaitIdle(dev);
+
+        for (FrameContext& frame : frames)
+        {
+            frame.descriptors.reset();
+            vkDestroyCommandPool(dev, frame.commandPool, c_device::allocator());
+            vkDestroySemaphore(dev, frame.imageAvailable, c_device::allocator());
+        }
+
+        if (uniformMemory) vkUnmapMemory(dev, uniformMemory);
+        if (uniformBuffer) vkDestroyBuffer(dev, uniformBuffer, c_device::allocator());
+        device.freeMemory(uniformMemory);
+    }
+
+    void FrameRing::createUniformBuffer(VkDeviceSize uboSize)
+    {
+        //one buffer, one aligned slice per frame, mapped for the lifetime of the ring
+        VkDeviceSize align = std::max<VkDeviceSize>(1, device.properties.limits.minUniformBufferOffsetAlignment);
+        uboStride = (uboSize + align - 1) & ~(align - 1);
+
+        device.createBuffer(
+            uboStride * frames.size(),
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            uniformBuffer,
+            uniformMemory,
+            MemoryCategory::Uniform,
+            "frame uniforms");
+
+        void* mapped = nullptr;
+        vkMapMemory(device.device(), uniformMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            frames[i].uboOffset = uboStride * i;
+            frames[i].uboMapped = static_cast<char*>(mapped) + uboStride * i;
+        }
+    }
+
+    void FrameRing::writeGlobalSet(FrameContext& frame)
+    {
+        //a fresh set every frame, it went back to the pool with the rest of the slot's sets
+        frame.globalSet = frame.descriptors->allocate(globalLayout);
+
+        VkDescriptorBufferInfo bufferInfo{ uniformBuffer, frame.uboOffset, uboSize };
+
+        VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        write.dstSet = frame.globalSet;
+        write.dstBinding = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &bufferInfo;
+        vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+    }
+
+    FrameContext& FrameRing::begin()
+    {
+        //mostly time spent waiting for the GPU to retire the slot
+        PROFILE_SCOPE("FrameRing::begin");
+        FrameContext& frame = current();
+        VkDevice dev = device.device();
+
+        device.waitForValue(frame.submitValue);
+
+        //the slot's last frame retired, so has everything deleted before it
+        device.collectDeletions();
+
+        vkResetCommandPool(dev, frame.commandPool, 0);
+        frame.descriptors->beginFrame();
+        frame.descriptors->reset();
+        writeGlobalSet(frame);
+        frame.frameNumber = ++frameNumber_;
+
+        return frame;
+    }
+
+    void FrameRing::submit(VkSemaphore renderFinished)
+    {
+        FrameContext& frame = current();
+
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+        VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &frame.commandBuffer;
+        if (renderFinished)
+        {
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &frame.imageAvailable;
+            submitInfo.pWaitDstStageMask = &waitStage;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &renderFinished;
+        }
+
+        frame.submitValue = device.submitGraphics(submitInfo);
+    }
+
+    void FrameRing::advance()
+    {
+        index_ = (index_ + 1) % uint32_t(frames.size());
+    }
+}
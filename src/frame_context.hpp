@@ -0,0 +1,75 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "device.hpp"
+#include "descriptor_allocator.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lavander
+{
+    // Everything one frame in flight records into. A slot is only touched again once
+    // the GPU finished the frame that used it last, independent of swapchain images.
+    struct FrameContext
+    {
+        VkCommandPool   commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkSemaphore     imageAvailable = VK_NULL_HANDLE; // present waits live per image, on the swapchain
+        uint64_t        submitValue = 0; // graphics timeline value of the slot's last submit
+
+        //this frame's slice of the shared uniform buffer, persistently mapped
+        VkDeviceSize    uboOffset = 0;
+        void*           uboMapped = nullptr;
+        VkDescriptorSet globalSet = VK_NULL_HANDLE; // set 0, points at the slice; from descriptors, rewritten in begin()
+
+        std::unique_ptr<DescriptorAllocator> descriptors; // transient, reset when the slot comes back
+
+        uint64_t frameNumber = 0; // frame last recorded into this slot
+    };
+
+    // Ring of 1-3 FrameContexts. Deeper rings let the CPU run further ahead of the GPU
+    // (more overlap, more latency), depth 1 waits for every frame.
+    class FrameRing
+    {
+    public:
+        static constexpr uint32_t kMaxDepth = 3;
+
+        FrameRing(c_device& device, uint32_t depth, VkDeviceSize uboSize, VkDescriptorSetLayout globalLayout);
+        ~FrameRing();
+
+        FrameRing(const FrameRing&) = delete;
+        FrameRing& operator=(const FrameRing&) = delete;
+
+        //waits for the slot's previous frame to retire, then recycles its commands and
+        //transient descriptors and runs the device's finished deletions
+        FrameContext& begin();
+        //submits the slot's command buffer and signals the next graphics timeline value. With a
+        //present semaphore it also waits on imageAvailable and signals it; offscreen frames pass none
+        void submit(VkSemaphore renderFinished = VK_NULL_HANDLE);
+        void advance();
+
+        //runs fn once the GPU is done with everything submitted so far
+        void defer(std::function<void()> fn) { device.deferDestroy(std::move(fn)); }
+
+        FrameContext& current() { return frames[index_]; }
+        uint32_t depth() const { return uint32_t(frames.size()); }
+        uint32_t index() const { return index_; }
+        uint64_t frameNumber() const { return frameNumber_; }
+
+    private:
+        void createUniformBuffer(VkDeviceSize uboSize);
+        void writeGlobalSet(FrameContext& frame);
+
+        c_device& device;
+        std::vector<FrameContext> frames;
+        uint32_t index_ = 0;
+        uint64_t frameNumber_ = 0;
+
+        VkBuffer         uniformBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory   uniformMemory = VK_NULL_HANDLE;
+        VkDeviceSize     uboStride = 0;
+        VkDeviceSize     uboSize = 0;
+        VkDescriptorSetLayout globalLayout = VK_NULL_HANDLE;
+    };
+}
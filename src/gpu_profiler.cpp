@@ -0,0 +1,181 @@
+#include "gpu_profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <imgui.h>
+
+namespace lavander
+{
+    GpuProfiler::GpuProfiler(c_device& device, uint32_t slotCount, uint32_t maxScopes)
+        : device(device), maxScopes(maxScopes)
+    {
+        slots.resize(slotCount);
+
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &familyCount, families.data());
+        uint32_t validBits = families[device.findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+        if (validBits == 0) return;
+
+        timestampPeriodNs = device.properties.limits.timestampPeriod;
+        timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+        for (Slot& slot : slots)
+        {
+            VkQueryPoolCreateInfo queryInfo{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+            queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryInfo.queryCount = maxScopes * 2;
+            if (vkCreateQueryPool(device.device(), &queryInfo, c_device::allocator(), &slot.pool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create gpu profiler query pool!");
+            }
+            slot.records.reserve(maxScopes);
+        }
+        readback.resize(maxScopes * 2);
+    }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        //pools may still be written by frames in flight
+        for (Slot& slot : slots)
+        {
+            if (!slot.pool) continue;
+            VkDevice dev = device.device();
+            VkQueryPool pool = slot.pool;
+            device.deferDestroy([dev, pool]() { vkDestroyQueryPool(dev, pool, c_device::allocator()); });
+        }
+    }
+
+    void GpuProfiler::collect(uint32_t slotIndex)
+    {
+        Slot& slot = slots[slotIndex];
+        if (!slot.written || slot.records.empty()) return;
+        slot.written = false;
+
+        //the frame retired, so no wait flag: anything not ready means it was never written
+        uint32_t queries = uint32_t(slot.records.size()) * 2;
+        if (vkGetQueryPoolResults(device.device(), slot.pool, 0, queries, queries * sizeof(uint64_t),
+            readback.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < slot.records.size(); i++)
+        {
+            uint64_t ticks = (readback[i * 2 + 1] - readback[i * 2]) & timestampMask;
+            addSample(slot.records[i], float(double(ticks) * timestampPeriodNs * 1e-6));
+        }
+    }
+
+    void GpuProfiler::addSample(const Record& record, float ms)
+    {
+        auto it = statIndex.find(record.name);
+        if (it == statIndex.end())
+        {
+            it = statIndex.emplace(record.name, stats.size()).first;
+            stats.emplace_back();
+            stats.back().name = record.name;
+        }
+
+        ScopeStats& s = stats[it->second];
+        s.depth = record.depth;
+        s.lastMs = ms;
+        s.history[s.next] = ms;
+        s.next = (s.next + 1) % kHistory;
+        s.samples = std::min(s.samples + 1, kHistory);
+
+        float sum = 0.0f;
+        s.minMs = s.maxMs = ms;
+        for (uint32_t i = 0; i < s.samples; i++)
+        {
+            sum += s.history[i];
+            s.minMs = std::min(s.minMs, s.history[i]);
+            s.maxMs = std::max(s.maxMs, s.history[i]);
+        }
+        s.avgMs = sum / float(s.samples);
+    }
+
+    void GpuProfiler::beginFrame(VkCommandBuffer cmd, uint32_t slotIndex)
+    {
+        current = slotIndex;
+        openDepth = 0;
+
+        Slot& slot = slots[slotIndex];
+        slot.records.clear();
+        if (!isSupported()) return;
+
+        vkCmdResetQueryPool(cmd, slot.pool, 0, maxScopes * 2);
+        slot.written = true;
+    }
+
+    uint32_t GpuProfiler::beginScope(VkCommandBuffer cmd, const char* name)
+    {
+        Slot& slot = slots[current];
+        if (!isSupported() || slot.records.size() >= maxScopes) return kNoScope;
+
+        uint32_t scope = uint32_t(slot.records.size());
+        slot.records.push_back({ name, openDepth++ });
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.pool, scope * 2);
+        return scope;
+    }
+
+    void GpuProfiler::endScope(VkCommandBuffer cmd, uint32_t scope)
+    {
+        if (scope == kNoScope) return;
+
+        openDepth--;
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slots[current].pool, scope * 2 + 1);
+    }
+
+    const GpuProfiler::ScopeStats* GpuProfiler::find(const std::string& name) const
+    {
+        auto it = statIndex.find(name);
+        return it != statIndex.end() ? &stats[it->second] : nullptr;
+    }
+
+    float GpuProfiler::lastMs(const std::string& name) const
+    {
+        const ScopeStats* s = find(name);
+        return s ? s->lastMs : 0.0f;
+    }
+
+    void GpuProfiler::OnImGuiRender()
+    {
+        ImGui::Begin("GPU Profiler");
+
+        if (!isSupported())
+        {
+            ImGui::TextUnformatted("The graphics queue doesn't support timestamps.");
+            ImGui::End();
+            return;
+        }
+
+        if (ImGui::BeginTable("##gpu_scopes", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+        {
+            ImGui::TableSetupColumn("Scope");
+            ImGui::TableSetupColumn("Last ms");
+            ImGui::TableSetupColumn("Avg ms");
+            ImGui::TableSetupColumn("Min ms");
+            ImGui::TableSetupColumn("Max ms");
+            ImGui::TableHeadersRow();
+
+            for (const ScopeStats& s : stats)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                if (s.depth) ImGui::Indent(s.depth * 12.0f);
+                ImGui::TextUnformatted(s.name.c_str());
+                if (s.depth) ImGui::Unindent(s.depth * 12.0f);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", s.lastMs);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", s.avgMs);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", s.minMs);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", s.maxMs);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::End();
+    }
+}
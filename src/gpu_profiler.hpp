@@ -0,0 +1,107 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "device.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lavander
+{
+    // Timestamp pairs around named GPU scopes, one query pool per frame in flight. A slot's
+    // queries are read when the slot comes around again, after its frame retired, so
+    // reading never stalls. Times are kept as rolling averages per scope.
+    class GpuProfiler
+    {
+    public:
+        static constexpr uint32_t kHistory = 120; // frames in the rolling window
+
+        struct ScopeStats
+        {
+            std::string name;
+            uint32_t depth = 0;  // nesting when last recorded
+            float lastMs = 0.0f;
+            float avgMs = 0.0f;
+            float minMs = 0.0f;
+            float maxMs = 0.0f;
+
+            float    history[kHistory] = {};
+            uint32_t samples = 0;
+            uint32_t next = 0;
+        };
+
+        GpuProfiler(c_device& device, uint32_t slots, uint32_t maxScopes = 32);
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+        //reads the slot's previous frame, call once the slot's submit value was waited on
+        void collect(uint32_t slot);
+
+        //resets the slot's queries, record first and outside any render pass
+        void beginFrame(VkCommandBuffer cmd, uint32_t slot);
+
+        //name must outlive the frame, string literals are fine. Returns the scope to end.
+        uint32_t beginScope(VkCommandBuffer cmd, const char* name);
+        void endScope(VkCommandBuffer cmd, uint32_t scope);
+
+        //0 until the scope was measured at least once
+        float lastMs(const std::string& name) const;
+        const ScopeStats* find(const std::string& name) const;
+        const std::vector<ScopeStats>& scopes() const { return stats; }
+
+        //false when the graphics queue can't write timestamps, scopes are then no-ops
+        bool isSupported() const { return timestampPeriodNs > 0.0f; }
+
+        void OnImGuiRender();
+
+    private:
+        static constexpr uint32_t kNoScope = ~0u;
+
+        struct Record
+        {
+            const char* name;
+            uint32_t    depth;
+        };
+
+        struct Slot
+        {
+            VkQueryPool pool = VK_NULL_HANDLE;
+            std::vector<Record> records; // query 2i begins record i, 2i+1 ends it
+            bool written = false;
+        };
+
+        void addSample(const Record& record, float ms);
+
+        c_device& device;
+        std::vector<Slot> slots;
+        uint32_t maxScopes;
+        uint32_t current = 0;
+        uint32_t openDepth = 0;
+
+        float    timestampPeriodNs = 0.0f;
+        uint64_t timestampMask = ~0ull;
+
+        std::vector<ScopeStats> stats;
+        std::unordered_map<std::string, size_t> statIndex;
+        std::vector<uint64_t> readback;
+    };
+
+    // Times its lifetime on the GPU.
+    class GpuScope
+    {
+    public:
+        GpuScope(GpuProfiler& profiler, VkCommandBuffer cmd, const char* name)
+            : profiler(profiler), cmd(cmd), scope(profiler.beginScope(cmd, name)) {}
+        ~GpuScope() { profiler.endScope(cmd, scope); }
+
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator=(const GpuScope&) = delete;
+
+    private:
+        GpuProfiler&    profiler;
+        VkCommandBuffer cmd;
+        uint32_t        scope;
+    };
+}
@@ -0,0 +1,234 @@
+#include "host_allocator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <imgui.h>
+
+namespace lavander
+{
+    namespace
+    {
+        //sits right in front of every block handed to the driver
+        struct BlockHeader
+        {
+            void*    base;  // what malloc returned
+            size_t   size;  // what the driver asked for
+            uint32_t scope;
+        };
+
+        BlockHeader* HeaderOf(void* memory)
+        {
+            return reinterpret_cast<BlockHeader*>(static_cast<char*>(memory) - sizeof(BlockHeader));
+        }
+    }
+
+    const char* AllocationScopeName(VkSystemAllocationScope scope)
+    {
+        switch (scope)
+        {
+        case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:  return "Command";
+        case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:   return "Object";
+        case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:    return "Cache";
+        case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:   return "Device";
+        case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE: return "Instance";
+        default:                                  return "Unknown";
+        }
+    }
+
+    HostAllocator& HostAllocator::Get()
+    {
+        static HostAllocator allocator;
+        return allocator;
+    }
+
+    HostAllocator::HostAllocator()
+    {
+        callbacks_.pUserData = this;
+        callbacks_.pfnAllocation = &HostAllocator::Allocate;
+        callbacks_.pfnReallocation = &HostAllocator::Reallocate;
+        callbacks_.pfnFree = &HostAllocator::Free;
+        callbacks_.pfnInternalAllocation = &HostAllocator::InternalAllocate;
+        callbacks_.pfnInternalFree = &HostAllocator::InternalFree;
+
+        history.assign(kHistory, 0.0f);
+    }
+
+    void* HostAllocator::allocate(size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        if (size == 0) return nullptr;
+
+        //room for the header plus enough slack to align the block after it
+        alignment = std::max(alignment, alignof(BlockHeader));
+        void* base = std::malloc(size + alignment + sizeof(BlockHeader));
+        if (!base) return nullptr;
+
+        uintptr_t first = reinterpret_cast<uintptr_t>(base) + sizeof(BlockHeader);
+        uintptr_t aligned = (first + alignment - 1) & ~uintptr_t(alignment - 1);
+        void* memory = reinterpret_cast<void*>(aligned);
+
+        uint32_t index = std::min<uint32_t>(uint32_t(scope), kScopes - 1);
+        *HeaderOf(memory) = { base, size, index };
+
+        Counters& c = counters[index];
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+        c.bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+        int64_t live = c.liveBytes.fetch_add(int64_t(size), std::memory_order_relaxed) + int64_t(size);
+        int64_t peak = c.peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !c.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+
+        return memory;
+    }
+
+    void HostAllocator::release(void* memory)
+    {
+        if (!memory) return;
+
+        BlockHeader header = *HeaderOf(memory);
+        Counters& c = counters[header.scope];
+        c.frees.fetch_add(1, std::memory_order_relaxed);
+        c.liveBytes.fetch_sub(int64_t(header.size), std::memory_order_relaxed);
+
+        std::free(header.base);
+    }
+
+    void* VKAPI_PTR HostAllocator::Allocate(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        return static_cast<HostAllocator*>(userData)->allocate(size, alignment, scope);
+    }
+
+    void* VKAPI_PTR HostAllocator::Reallocate(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        HostAllocator* self = static_cast<HostAllocator*>(userData);
+
+        //spec: no original behaves like pfnAllocation, size 0 like pfnFree
+        if (!original) return self->allocate(size, alignment, scope);
+        if (size == 0)
+        {
+            self->release(original);
+            return nullptr;
+        }
+
+        //a new block every time, alignment has to be preserved and malloc's realloc can't
+        void* memory = self->allocate(size, alignment, scope);
+        if (!memory) return nullptr; // original stays valid
+        std::memcpy(memory, original, std::min(size, HeaderOf(original)->size));
+        self->release(original);
+        return memory;
+    }
+
+    void VKAPI_PTR HostAllocator::Free(void* userData, void* memory)
+    {
+        static_cast<HostAllocator*>(userData)->release(memory);
+    }
+
+    void VKAPI_PTR HostAllocator::InternalAllocate(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+    {
+        HostAllocator* self = static_cast<HostAllocator*>(userData);
+        self->counters[std::min<size_t>(size_t(scope), kScopes - 1)].internalBytes.fetch_add(int64_t(size), std::memory_order_relaxed);
+    }
+
+    void VKAPI_PTR HostAllocator::InternalFree(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+    {
+        HostAllocator* self = static_cast<HostAllocator*>(userData);
+        self->counters[std::min<size_t>(size_t(scope), kScopes - 1)].internalBytes.fetch_sub(int64_t(size), std::memory_order_relaxed);
+    }
+
+    void HostAllocator::endFrame()
+    {
+        uint64_t frameTotal = 0;
+        for (size_t i = 0; i < kScopes; i++)
+        {
+            uint64_t allocations = counters[i].allocations.load(std::memory_order_relaxed);
+            uint64_t bytes = counters[i].bytesAllocated.load(std::memory_order_relaxed);
+            lastFrameAllocations[i] = allocations - frameStartAllocations[i];
+            lastFrameBytes[i] = bytes - frameStartBytes[i];
+            frameStartAllocations[i] = allocations;
+            frameStartBytes[i] = bytes;
+            frameTotal += lastFrameAllocations[i];
+        }
+
+        history[historyNext] = float(frameTotal);
+        historyNext = (historyNext + 1) % kHistory;
+    }
+
+    HostAllocator::ScopeStats HostAllocator::stats(VkSystemAllocationScope scope) const
+    {
+        size_t i = std::min<size_t>(size_t(scope), kScopes - 1);
+        const Counters& c = counters[i];
+
+        ScopeStats s;
+        s.allocations = c.allocations.load(std::memory_order_relaxed);
+        s.frees = c.frees.load(std::memory_order_relaxed);
+        s.bytesAllocated = c.bytesAllocated.load(std::memory_order_relaxed);
+        s.liveBytes = c.liveBytes.load(std::memory_order_relaxed);
+        s.peakBytes = c.peakBytes.load(std::memory_order_relaxed);
+        s.internalBytes = c.internalBytes.load(std::memory_order_relaxed);
+        s.frameAllocations = lastFrameAllocations[i];
+        s.frameBytes = lastFrameBytes[i];
+        return s;
+    }
+
+    HostAllocator::ScopeStats HostAllocator::total() const
+    {
+        ScopeStats sum;
+        for (size_t i = 0; i < kScopes; i++)
+        {
+            ScopeStats s = stats(VkSystemAllocationScope(i));
+            sum.allocations += s.allocations;
+            sum.frees += s.frees;
+            sum.bytesAllocated += s.bytesAllocated;
+            sum.liveBytes += s.liveBytes;
+            sum.peakBytes += s.peakBytes; // per scope peaks, an upper bound
+            sum.internalBytes += s.internalBytes;
+            sum.frameAllocations += s.frameAllocations;
+            sum.frameBytes += s.frameBytes;
+        }
+        return sum;
+    }
+
+    void HostAllocator::OnImGuiRender()
+    {
+        ImGui::Begin("Driver Allocations");
+
+        auto kb = [](int64_t bytes) { return double(bytes) / 1024.0; };
+        ScopeStats sum = total();
+
+        ImGui::Text("Last frame: %llu allocations, %.1f KB", (unsigned long long)sum.frameAllocations, kb(int64_t(sum.frameBytes)));
+        ImGui::Text("Live: %.1f KB in %llu blocks", kb(sum.liveBytes), (unsigned long long)(sum.allocations - sum.frees));
+
+        char overlay[32];
+        std::snprintf(overlay, sizeof(overlay), "%llu / frame", (unsigned long long)sum.frameAllocations);
+        float maxValue = std::max(1.0f, *std::max_element(history.begin(), history.end()));
+        ImGui::PlotHistogram("##driver_alloc_history", history.data(), int(history.size()), int(historyNext),
+            overlay, 0.0f, maxValue, ImVec2(-1.0f, 60.0f));
+
+        if (ImGui::BeginTable("##driver_alloc_scopes", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable))
+        {
+            ImGui::TableSetupColumn("Scope");
+            ImGui::TableSetupColumn("Frame");
+            ImGui::TableSetupColumn("Live");
+            ImGui::TableSetupColumn("Peak");
+            ImGui::TableSetupColumn("Total");
+            ImGui::TableHeadersRow();
+
+            for (size_t i = 0; i < kScopes; i++)
+            {
+                ScopeStats s = stats(VkSystemAllocationScope(i));
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(AllocationScopeName(VkSystemAllocationScope(i)));
+                ImGui::TableNextColumn(); ImGui::Text("%llu (%.1f KB)", (unsigned long long)s.frameAllocations, kb(int64_t(s.frameBytes)));
+                ImGui::TableNextColumn(); ImGui::Text("%.1f KB", kb(s.liveBytes));
+                ImGui::TableNextColumn(); ImGui::Text("%.1f KB", kb(s.peakBytes));
+                ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)s.allocations);
+            }
+            ImGui::EndTable();
+        }
+
+        if (sum.internalBytes) ImGui::Text("Driver internal: %.1f KB", kb(sum.internalBytes));
+
+        ImGui::End();
+    }
+}
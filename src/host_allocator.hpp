@@ -0,0 +1,84 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace lavander
+{
+    const char* AllocationScopeName(VkSystemAllocationScope scope);
+
+    // VkAllocationCallbacks handed to every vkCreate*/vkDestroy* and vkAllocateMemory call,
+    // so the driver's host allocations can be counted per allocation scope (command, object,
+    // cache, device, instance). Blocks still come from malloc; each carries a small header
+    // with its size and scope so frees and reallocations can be accounted without a lookup.
+    // endFrame() turns the running totals into per frame churn.
+    class HostAllocator
+    {
+    public:
+        static constexpr size_t kScopes = size_t(VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE) + 1;
+        static constexpr size_t kHistory = 120;
+
+        struct ScopeStats
+        {
+            uint64_t allocations = 0;   // since startup, reallocations count as one
+            uint64_t frees = 0;
+            uint64_t bytesAllocated = 0;
+            int64_t  liveBytes = 0;
+            int64_t  peakBytes = 0;
+            int64_t  internalBytes = 0; // driver allocations it only reports (executable memory)
+
+            uint64_t frameAllocations = 0; // during the last closed frame
+            uint64_t frameBytes = 0;
+        };
+
+        static HostAllocator& Get();
+
+        //what the Vulkan calls take, the same pointer for every create and its destroy
+        const VkAllocationCallbacks* callbacks() const { return &callbacks_; }
+
+        //closes the frame, the frame* fields of stats() then cover it
+        void endFrame();
+
+        ScopeStats stats(VkSystemAllocationScope scope) const;
+        //all scopes summed
+        ScopeStats total() const;
+
+        void OnImGuiRender();
+
+    private:
+        struct Counters
+        {
+            std::atomic<uint64_t> allocations{ 0 };
+            std::atomic<uint64_t> frees{ 0 };
+            std::atomic<uint64_t> bytesAllocated{ 0 };
+            std::atomic<int64_t>  liveBytes{ 0 };
+            std::atomic<int64_t>  peakBytes{ 0 };
+            std::atomic<int64_t>  internalBytes{ 0 };
+        };
+
+        HostAllocator();
+
+        static void* VKAPI_PTR Allocate(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        static void* VKAPI_PTR Reallocate(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        static void  VKAPI_PTR Free(void* userData, void* memory);
+        static void  VKAPI_PTR InternalAllocate(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+        static void  VKAPI_PTR InternalFree(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+
+        void* allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+        void  release(void* memory);
+
+        VkAllocationCallbacks callbacks_{};
+        Counters counters[kScopes];
+
+        //totals at the start of the frame being recorded, and what the last frame added
+        uint64_t frameStartAllocations[kScopes] = {};
+        uint64_t frameStartBytes[kScopes] = {};
+        uint64_t lastFrameAllocations[kScopes] = {};
+        uint64_t lastFrameBytes[kScopes] = {};
+
+        std::vector<float> history; // allocations per frame, all scopes
+        uint32_t historyNext = 0;
+    };
+}
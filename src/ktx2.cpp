@@ -0,0 +1,195 @@
+#include "ktx2.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace lavander
+{
+    namespace
+    {
+        const uint8_t kIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+        struct Header
+        {
+            uint8_t  identifier[12];
+            uint32_t vkFormat;
+            uint32_t typeSize;
+            uint32_t pixelWidth;
+            uint32_t pixelHeight;
+            uint32_t pixelDepth;
+            uint32_t layerCount;
+            uint32_t faceCount;
+            uint32_t levelCount;
+            uint32_t supercompressionScheme;
+            uint32_t dfdByteOffset;
+            uint32_t dfdByteLength;
+            uint32_t kvdByteOffset;
+            uint32_t kvdByteLength;
+            uint64_t sgdByteOffset;
+            uint64_t sgdByteLength;
+        };
+        static_assert(sizeof(Header) == 80, "KTX2 header must be 80 bytes");
+
+        struct LevelIndex
+        {
+            uint64_t byteOffset;
+            uint64_t byteLength;
+            uint64_t uncompressedByteLength;
+        };
+
+        constexpr uint64_t kLevelAlignment = 16;
+    }
+
+    bool IsBlockCompressed(VkFormat format)
+    {
+        return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+    }
+
+    uint32_t BlockBytes(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+            return 8;
+        default:
+            return IsBlockCompressed(format) ? 16 : 4;
+        }
+    }
+
+    bool Ktx2File::IsKtx2Path(const std::string& path)
+    {
+        std::string ext = std::filesystem::path(path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == ".ktx2";
+    }
+
+    Ktx2File::Ktx2File(const std::string& path) : file(path, std::ios::binary), path_(path)
+    {
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open ktx2: " + path);
+        }
+
+        Header header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || std::memcmp(header.identifier, kIdentifier, sizeof(kIdentifier)) != 0)
+        {
+            throw std::runtime_error("not a ktx2 file: " + path);
+        }
+        if (header.supercompressionScheme != 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+        {
+            throw std::runtime_error("unsupported ktx2 layout (only plain 2D textures): " + path);
+        }
+
+        format_ = VkFormat(header.vkFormat);
+        width_ = header.pixelWidth;
+        height_ = header.pixelHeight;
+
+        uint32_t count = std::max(1u, header.levelCount);
+        std::vector<LevelIndex> index(count);
+        file.read(reinterpret_cast<char*>(index.data()), std::streamsize(sizeof(LevelIndex) * count));
+        if (!file)
+        {
+            throw std::runtime_error("truncated ktx2 level index: " + path);
+        }
+
+        levels_.resize(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            levels_[i].offset = index[i].byteOffset;
+            levels_[i].size = index[i].byteLength;
+            levels_[i].width = std::max(1u, width_ >> i);
+            levels_[i].height = std::max(1u, height_ >> i);
+        }
+    }
+
+    std::vector<uint8_t> Ktx2File::readLevel(uint32_t level)
+    {
+        const Level& l = levels_.at(level);
+        std::vector<uint8_t> data(size_t(l.size));
+
+        file.clear();
+        file.seekg(std::streamoff(l.offset));
+        file.read(reinterpret_cast<char*>(data.data()), std::streamsize(l.size));
+        if (!file)
+        {
+            throw std::runtime_error("failed to read ktx2 level " + std::to_string(level) + ": " + path_);
+        }
+        return data;
+    }
+
+    MipChain Ktx2File::readLevels(uint32_t first, uint32_t count)
+    {
+        MipChain chain;
+        size_t total = 0;
+        for (uint32_t i = first; i < first + count && i < levelCount(); i++)
+        {
+            const Level& l = levels_[i];
+            chain.levels.push_back({ l.width, l.height, total, size_t(l.size) });
+            total += size_t(l.size);
+        }
+
+        chain.data.resize(total);
+        for (size_t i = 0; i < chain.levels.size(); i++)
+        {
+            std::vector<uint8_t> bytes = readLevel(first + uint32_t(i));
+            std::memcpy(chain.data.data() + chain.levels[i].offset, bytes.data(), bytes.size());
+        }
+        return chain;
+    }
+
+    void Ktx2File::Write(const std::string& path, VkFormat format, const MipChain& chain)
+    {
+        const uint32_t count = uint32_t(chain.levels.size());
+
+        Header header{};
+        std::memcpy(header.identifier, kIdentifier, sizeof(kIdentifier));
+        header.vkFormat = uint32_t(format);
+        header.typeSize = 1;
+        header.pixelWidth = chain.levels[0].width;
+        header.pixelHeight = chain.levels[0].height;
+        header.faceCount = 1;
+        header.levelCount = count;
+
+        //data goes smallest level first, right after the index
+        std::vector<LevelIndex> index(count);
+        uint64_t cursor = sizeof(Header) + sizeof(LevelIndex) * count;
+        for (int i = int(count) - 1; i >= 0; i--)
+        {
+            cursor = (cursor + kLevelAlignment - 1) & ~(kLevelAlignment - 1);
+            index[i].byteOffset = cursor;
+            index[i].byteLength = chain.levels[i].size;
+            index[i].uncompressedByteLength = chain.levels[i].size;
+            cursor += chain.levels[i].size;
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            throw std::runtime_error("failed to write ktx2: " + path);
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(index.data()), std::streamsize(sizeof(LevelIndex) * count));
+
+        const char zeros[kLevelAlignment] = {};
+        for (int i = int(count) - 1; i >= 0; i--)
+        {
+            uint64_t pos = uint64_t(out.tellp());
+            out.write(zeros, std::streamsize(index[i].byteOffset - pos));
+            out.write(reinterpret_cast<const char*>(chain.data.data() + chain.levels[i].offset), std::streamsize(chain.levels[i].size));
+        }
+
+        if (!out)
+        {
+            throw std::runtime_error("failed to write ktx2: " + path);
+        }
+    }
+}
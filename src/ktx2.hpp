@@ -0,0 +1,53 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "mip_chain.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace lavander
+{
+    // Minimal KTX2 container: header + level index + raw level data, no supercompression
+    // and no data format descriptor (the vkFormat field is all we read back).
+    // Levels are stored smallest first and every level can be read on its own.
+    class Ktx2File
+    {
+    public:
+        struct Level
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t width = 0;
+            uint32_t height = 0;
+        };
+
+        explicit Ktx2File(const std::string& path);
+
+        VkFormat format()     const { return format_; }
+        uint32_t width()      const { return width_; }
+        uint32_t height()     const { return height_; }
+        uint32_t levelCount() const { return uint32_t(levels_.size()); }
+        const Level& level(uint32_t i) const { return levels_[i]; }
+
+        //reads levels [first, first + count) into a packed chain, level `first` becomes chain level 0
+        MipChain readLevels(uint32_t first, uint32_t count);
+        std::vector<uint8_t> readLevel(uint32_t level);
+
+        static void Write(const std::string& path, VkFormat format, const MipChain& chain);
+        static bool IsKtx2Path(const std::string& path);
+
+    private:
+        std::ifstream      file;
+        std::string        path_;
+        VkFormat           format_ = VK_FORMAT_UNDEFINED;
+        uint32_t           width_ = 0;
+        uint32_t           height_ = 0;
+        std::vector<Level> levels_;
+    };
+
+    //block footprint helpers for the formats we cook
+    bool     IsBlockCompressed(VkFormat format);
+    uint32_t BlockBytes(VkFormat format);
+}
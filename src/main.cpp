@@ -1,40 +1,228 @@
 #include "engine.hpp"
 #include "components.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include "mesh.hpp"
+#include "runtime.hpp"
+#include "texture_cooker.hpp"
 
-int main()
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <string>
+
+//VulkanEngine --startup-bench: create the engine, report startup time, exit
+//VulkanEngine --frames-in-flight N: 1-3 frames recorded ahead of the GPU (default 2)
+//VulkanEngine --offscreen --frames N [--width W --height H] [--out last.ppm]: no window or swapchain,
+//  renders N frames of the demo scene and optionally writes the last one out
+//VulkanEngine --stats-csv stats.csv: one row of render counters and frame-time percentiles per frame
+//VulkanEngine --headless --frames N [--entities M]: simulation only, no window or device,
+//  ticks N times over M spinning entities and reports ticks per second
+//offline: VulkanEngine --cook <input image> <output.ktx2> [--color|--normal|--mask]
+static int CookTexture(int argc, char** argv)
 {
-    lavander::Engine engine{};
+    lavander::TextureUsage usage = lavander::TextureUsage::Auto;
+    if (argc >= 5)
+    {
+        std::string u = argv[4];
+        if (u == "--color") usage = lavander::TextureUsage::Color;
+        else if (u == "--normal") usage = lavander::TextureUsage::NormalMap;
+        else if (u == "--mask") usage = lavander::TextureUsage::Mask;
+    }
 
-    try 
+    try
+    {
+        auto r = lavander::TextureCooker::CookFile(argv[2], argv[3], usage);
+        std::cout << "cooked " << argv[2] << " (" << r.width << "x" << r.height << ", format " << r.format << ") "
+            << r.sourceBytes / 1024 << " KB -> " << r.cookedBytes / 1024 << " KB\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+static void BuildDemoScene(lavander::Engine& engine)
+{
+    auto& reg = engine.getRegistry();
+    auto e = reg.createEntity();
+
+    reg.addComponent<lavander::Transform>(e,
+        {
+            glm::vec3(0.0f,0.0f,0.0f),
+            glm::vec3(0.0f, glm::radians(0.0f), 0.0f),
+            glm::vec3(0.5f, 0.5f, 0.5f)          
+        
+        });
+    
+    auto tex = engine.getTextureCache().acquire("../../src/assets/default_texture.png");
+
+    reg.addComponent<lavander::SpriteRenderer>(e, { glm::vec3(1.0f), tex });
+
+    auto cubeMesh = lavander::Mesh::MakeCube(engine.getDevice());
+    auto e2 = reg.createEntity();
+    reg.addComponent<lavander::MeshFilter>(e2, { cubeMesh });
+    reg.addComponent<lavander::MeshRenderer3D>(e2, { nullptr, glm::vec3(1.0f,0.0f,0.0f) });
+    reg.addComponent<lavander::Transform>(e2, {{0,0,-2}, {0,0,0},{1,1,1} });
+}
+
+//binary ppm, drops alpha
+static void WritePpm(const std::string& path, VkExtent2D extent, const uint8_t* rgba)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+    for (size_t i = 0; i < size_t(extent.width) * extent.height; i++)
+    {
+        out.write(reinterpret_cast<const char*>(rgba + i * 4), 3);
+    }
+}
+
+static int RunHeadless(int argc, char** argv)
+{
+    uint32_t frames = 1000;
+    uint32_t entityCount = 10000;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--frames") frames = uint32_t(std::atoi(argv[i + 1]));
+        else if (arg == "--entities") entityCount = uint32_t(std::atoi(argv[i + 1]));
+    }
+
+    lavander::Runtime runtime;
+    auto& reg = runtime.registry();
+
+    //a grid of unit cubes on the xz plane
+    uint32_t side = 1;
+    while (side * side < entityCount) side++;
+    for (uint32_t i = 0; i < entityCount; i++)
     {
-        auto& reg = engine.getRegistry();
         auto e = reg.createEntity();
+        glm::vec3 pos{ float(i % side) - side * 0.5f, 0.0f, -float(i / side) };
+        reg.addComponent<lavander::Transform>(e, { pos, {0,0,0}, {1,1,1} });
+    }
 
-        reg.addComponent<lavander::Transform>(e,
+    runtime.addSystem("spin", [](lavander::ECSRegistry& reg, float dt)
+        {
+            for (auto& [entity, transforms] : reg.getAllComponentsOfType<lavander::Transform>())
             {
-                glm::vec3(0.0f,0.0f,0.0f),
-                glm::vec3(0.0f, glm::radians(0.0f), 0.0f),
-                glm::vec3(0.5f, 0.5f, 0.5f)          
-            
-            });
-        
-        auto tex = std::make_shared<lavander::Texture2D>(engine.getDevice(), "../../src/assets/default_texture.png");
+                for (auto& t : transforms) t.rotation.y += dt;
+            }
+        });
+
+    //what the renderers do per entity on the CPU: build the model matrix and test it against the view
+    size_t visible = 0;
+    glm::mat4 viewProj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f)
+        * glm::lookAt(glm::vec3(0, 10, 10), glm::vec3(0, 0, -10), glm::vec3(0, 1, 0));
+    runtime.addSystem("cull", [&](lavander::ECSRegistry& reg, float)
+        {
+            visible = 0;
+            for (auto& [entity, transforms] : reg.getAllComponentsOfType<lavander::Transform>())
+            {
+                for (auto& t : transforms)
+                {
+                    glm::mat4 model = glm::translate(glm::mat4(1.0f), t.position)
+                        * glm::rotate(glm::mat4(1.0f), t.rotation.z, { 0,0,1 })
+                        * glm::rotate(glm::mat4(1.0f), t.rotation.y, { 0,1,0 })
+                        * glm::rotate(glm::mat4(1.0f), t.rotation.x, { 1,0,0 });
+                    model = glm::scale(model, t.scale);
 
-        tex->allocateDescriptor(engine.getMaterialDescriptorPool(), engine.getMaterialSetLayout());
+                    //bounding sphere of a unit cube, in clip space
+                    glm::vec4 c = viewProj * model * glm::vec4(0, 0, 0, 1);
+                    float r = 0.87f * std::max(t.scale.x, std::max(t.scale.y, t.scale.z));
+                    if (c.w > -r && std::abs(c.x) <= c.w + r && std::abs(c.y) <= c.w + r) visible++;
+                }
+            }
+        });
+
+    auto begin = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; i++) runtime.tick(1.0f / 60.0f);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "headless: " << frames << " ticks over " << entityCount << " entities in " << ms << " ms ("
+        << (ms > 0.0 ? frames * 1000.0 / ms : 0.0) << " ticks/s, " << visible << " visible)\n";
+    for (const auto& system : runtime.systems())
+    {
+        std::cout << "  " << system.name << ": " << system.lastMs << " ms last tick\n";
+    }
+    return EXIT_SUCCESS;
+}
 
-        reg.addComponent<lavander::SpriteRenderer>(e, { glm::vec3(1.0f), tex });
+int main(int argc, char** argv)
+{
+    if (argc >= 4 && std::string(argv[1]) == "--cook")
+    {
+        return CookTexture(argc, argv);
+    }
 
-        auto cubeMesh = lavander::Mesh::MakeCube(engine.getDevice());
-        auto e2 = reg.createEntity();
-        reg.addComponent<lavander::MeshFilter>(e2, { cubeMesh });
-        reg.addComponent<lavander::MeshRenderer3D>(e2, { nullptr, glm::vec3(1.0f,0.0f,0.0f) });
-        reg.addComponent<lavander::Transform>(e2, {{0,0,-2}, {0,0,0},{1,1,1} });
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--headless") return RunHeadless(argc, argv);
+    }
+
+    lavander::EngineConfig config;
+    uint32_t offscreenFrames = 100;
+    std::string outPath;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--offscreen") config.offscreen = true;
+        if (i + 1 >= argc) continue;
+        if (arg == "--frames-in-flight") config.framesInFlight = uint32_t(std::atoi(argv[i + 1]));
+        else if (arg == "--frames") offscreenFrames = uint32_t(std::atoi(argv[i + 1]));
+        else if (arg == "--width") config.offscreenExtent.width = uint32_t(std::atoi(argv[i + 1]));
+        else if (arg == "--height") config.offscreenExtent.height = uint32_t(std::atoi(argv[i + 1]));
+        else if (arg == "--out") outPath = argv[i + 1];
+        else if (arg == "--stats-csv" && !lavander::RenderStats::Get().startCsv(argv[i + 1]))
+        {
+            std::cerr << "can't write " << argv[i + 1] << '\n';
+        }
+    }
+
+    //frames arrive in order, only the last one is kept
+    uint64_t lastWritten = 0;
+    if (config.offscreen && !outPath.empty())
+    {
+        config.onReadback = [&](uint64_t frame, VkExtent2D extent, const uint8_t* pixels)
+        {
+            if (frame != offscreenFrames) return;
+            WritePpm(outPath, extent, pixels);
+            lastWritten = frame;
+        };
+    }
+
+    //startup time, run with --startup-bench twice to compare a cold and a warm pipeline cache
+    auto startupBegin = std::chrono::steady_clock::now();
+    lavander::Engine engine{ config };
+    double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+    std::cout << "startup: " << startupMs << " ms (pipeline cache "
+        << (engine.getDevice().pipelineCacheWarm() ? "warm" : "cold") << ")\n";
+
+    if (argc >= 2 && std::string(argv[1]) == "--startup-bench")
+    {
+        return EXIT_SUCCESS;
+    }
+
+    try 
+    {
+        BuildDemoScene(engine);
 
+        if (engine.isOffscreen())
+        {
+            auto begin = std::chrono::steady_clock::now();
+            engine.renderOffscreen(offscreenFrames);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            std::cout << "offscreen: " << offscreenFrames << " frames in " << ms << " ms ("
+                << (ms > 0.0 ? offscreenFrames * 1000.0 / ms : 0.0) << " fps)\n";
+            if (lastWritten) std::cout << "wrote frame " << lastWritten << " to " << outPath << "\n";
+            return EXIT_SUCCESS;
+        }
 
         engine.run();
 
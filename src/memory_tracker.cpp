@@ -0,0 +1,200 @@
+#include "memory_tracker.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+#include <imgui.h>
+
+namespace lavander
+{
+    const char* MemoryCategoryName(MemoryCategory category)
+    {
+        switch (category)
+        {
+        case MemoryCategory::Texture:      return "Textures";
+        case MemoryCategory::Mesh:         return "Meshes";
+        case MemoryCategory::RenderTarget: return "Render targets";
+        case MemoryCategory::Uniform:      return "Uniforms";
+        case MemoryCategory::Staging:      return "Staging";
+        case MemoryCategory::Readback:     return "Readback";
+        default:                           return "Other";
+        }
+    }
+
+    void MemoryTracker::init(VkPhysicalDevice physicalDevice, bool budgetSupported)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->physicalDevice = physicalDevice;
+        budgetSupported_ = budgetSupported;
+
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+        heaps_.assign(memoryProperties.memoryHeapCount, HeapUsage{});
+        warned.assign(memoryProperties.memoryHeapCount, false);
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+        {
+            heaps_[i].size = memoryProperties.memoryHeaps[i].size;
+            heaps_[i].deviceLocal = (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        }
+    }
+
+    void MemoryTracker::onAllocate(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex,
+        MemoryCategory category, const std::string& owner)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t heap = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        allocations[memory] = { size, heap, category, owner.empty() ? std::string(MemoryCategoryName(category)) : owner };
+
+        HeapUsage& h = heaps_[heap];
+        h.tracked += size;
+        h.byCategory[size_t(category)] += size;
+        h.allocations++;
+    }
+
+    void MemoryTracker::onFree(VkDeviceMemory memory)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = allocations.find(memory);
+        if (it == allocations.end()) return;
+
+        HeapUsage& h = heaps_[it->second.heap];
+        h.tracked -= it->second.size;
+        h.byCategory[size_t(it->second.category)] -= it->second.size;
+        h.allocations--;
+        allocations.erase(it);
+    }
+
+    void MemoryTracker::refreshBudget()
+    {
+        if (!budgetSupported_) return;
+
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT };
+        VkPhysicalDeviceMemoryProperties2 props{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2 };
+        props.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &props);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < heaps_.size(); i++)
+        {
+            HeapUsage& h = heaps_[i];
+            h.budget = budget.heapBudget[i];
+            h.usage = budget.heapUsage[i];
+            if (h.budget == 0) continue;
+
+            //warn once on the way up, re-arm a little below so it doesn't flicker
+            float used = float(double(h.usage) / double(h.budget));
+            if (used >= warnFraction && !warned[i])
+            {
+                warned[i] = true;
+                std::cout << "memory: heap " << i << (h.deviceLocal ? " (device local)" : "") << " at "
+                    << int(used * 100.0f) << "% of its " << h.budget / (1024 * 1024) << " MB budget" << std::endl;
+            }
+            else if (used < warnFraction - 0.05f)
+            {
+                warned[i] = false;
+            }
+        }
+    }
+
+    std::vector<MemoryTracker::HeapUsage> MemoryTracker::heaps() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return heaps_;
+    }
+
+    VkDeviceSize MemoryTracker::categoryBytes(MemoryCategory category) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        VkDeviceSize total = 0;
+        for (const HeapUsage& h : heaps_) total += h.byCategory[size_t(category)];
+        return total;
+    }
+
+    std::vector<MemoryTracker::OwnerUsage> MemoryTracker::owners(size_t maxCount) const
+    {
+        std::vector<OwnerUsage> result;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::unordered_map<std::string, size_t> index;
+            for (const auto& [memory, a] : allocations)
+            {
+                auto [it, inserted] = index.emplace(a.owner, result.size());
+                if (inserted) result.push_back({ a.owner, a.category, 0, 0 });
+                result[it->second].bytes += a.size;
+                result[it->second].allocations++;
+            }
+        }
+
+        std::sort(result.begin(), result.end(), [](const OwnerUsage& a, const OwnerUsage& b) { return a.bytes > b.bytes; });
+        if (result.size() > maxCount) result.resize(maxCount);
+        return result;
+    }
+
+    VkDeviceSize MemoryTracker::deviceLocalHeadroom() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        VkDeviceSize headroom = 0;
+        for (const HeapUsage& h : heaps_)
+        {
+            if (!h.deviceLocal) continue;
+            if (h.budget) headroom += h.budget > h.usage ? h.budget - h.usage : 0;
+            else headroom += h.size > h.tracked ? h.size - h.tracked : 0;
+        }
+        return headroom;
+    }
+
+    void MemoryTracker::OnImGuiRender()
+    {
+        ImGui::Begin("Memory");
+
+        auto mb = [](VkDeviceSize bytes) { return double(bytes) / (1024.0 * 1024.0); };
+        std::vector<HeapUsage> heapList = heaps();
+
+        if (!budgetSupported_) ImGui::TextUnformatted("VK_EXT_memory_budget unavailable, showing tracked totals only");
+
+        for (size_t i = 0; i < heapList.size(); i++)
+        {
+            const HeapUsage& h = heapList[i];
+            ImGui::Text("Heap %zu%s  %.0f MB", i, h.deviceLocal ? " (device local)" : "", mb(h.size));
+
+            VkDeviceSize limit = h.budget ? h.budget : h.size;
+            VkDeviceSize used = h.budget ? h.usage : h.tracked;
+            char label[96];
+            std::snprintf(label, sizeof(label), "%.1f / %.1f MB (engine %.1f MB, %u allocations)",
+                mb(used), mb(limit), mb(h.tracked), h.allocations);
+            float fraction = limit ? float(double(used) / double(limit)) : 0.0f;
+            if (fraction >= warnFraction) ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(0.9f, 0.3f, 0.2f, 1.0f));
+            ImGui::ProgressBar(fraction, ImVec2(-1.0f, 0.0f), label);
+            if (fraction >= warnFraction) ImGui::PopStyleColor();
+        }
+
+        ImGui::SeparatorText("Categories");
+        if (ImGui::BeginTable("##memory_categories", 2, ImGuiTableFlags_RowBg))
+        {
+            for (size_t c = 0; c < kCategories; c++)
+            {
+                VkDeviceSize total = 0;
+                for (const HeapUsage& h : heapList) total += h.byCategory[c];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(MemoryCategoryName(MemoryCategory(c)));
+                ImGui::TableNextColumn(); ImGui::Text("%.2f MB", mb(total));
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::SeparatorText("Largest owners");
+        if (ImGui::BeginTable("##memory_owners", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable))
+        {
+            for (const OwnerUsage& o : owners())
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(o.owner.c_str());
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(MemoryCategoryName(o.category));
+                ImGui::TableNextColumn(); ImGui::Text("%.2f MB (%u)", mb(o.bytes), o.allocations);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::End();
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lavander
+{
+    enum class MemoryCategory : uint8_t
+    {
+        Texture,
+        Mesh,
+        RenderTarget,
+        Uniform,
+        Staging,
+        Readback,
+        Other,
+        Count
+    };
+
+    const char* MemoryCategoryName(MemoryCategory category);
+
+    // Live accounting of every VkDeviceMemory the device hands out, per heap, category and
+    // owner. With VK_EXT_memory_budget the driver's budget and usage per heap are read too,
+    // and a warning is printed once a heap gets close to its budget.
+    class MemoryTracker
+    {
+    public:
+        static constexpr size_t kCategories = size_t(MemoryCategory::Count);
+
+        struct HeapUsage
+        {
+            VkDeviceSize size = 0;
+            bool         deviceLocal = false;
+            VkDeviceSize tracked = 0;   // what went through the tracker
+            VkDeviceSize budget = 0;    // driver numbers, 0 without VK_EXT_memory_budget
+            VkDeviceSize usage = 0;
+            VkDeviceSize byCategory[kCategories] = {};
+            uint32_t     allocations = 0;
+        };
+
+        struct OwnerUsage
+        {
+            std::string    owner;
+            MemoryCategory category;
+            VkDeviceSize   bytes;
+            uint32_t       allocations;
+        };
+
+        void init(VkPhysicalDevice physicalDevice, bool budgetSupported);
+
+        void onAllocate(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex,
+            MemoryCategory category, const std::string& owner);
+        void onFree(VkDeviceMemory memory);
+
+        //re-reads the driver's budget and usage, call every few frames
+        void refreshBudget();
+
+        std::vector<HeapUsage> heaps() const;
+        VkDeviceSize categoryBytes(MemoryCategory category) const;
+        //largest owners first
+        std::vector<OwnerUsage> owners(size_t maxCount = 32) const;
+
+        //what the device local heaps can still take: budget minus usage with the extension,
+        //heap size minus tracked bytes without it
+        VkDeviceSize deviceLocalHeadroom() const;
+
+        bool budgetSupported() const { return budgetSupported_; }
+        void setWarnFraction(float fraction) { warnFraction = fraction; }
+
+        void OnImGuiRender();
+
+    private:
+        struct Allocation
+        {
+            VkDeviceSize   size;
+            uint32_t       heap;
+            MemoryCategory category;
+            std::string    owner;
+        };
+
+        mutable std::mutex mutex;
+        VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+        bool budgetSupported_ = false;
+        VkPhysicalDeviceMemoryProperties memoryProperties{};
+
+        std::unordered_map<VkDeviceMemory, Allocation> allocations;
+        std::vector<HeapUsage> heaps_;
+        std::vector<bool> warned;
+        float warnFraction = 0.9f;
+    };
+}
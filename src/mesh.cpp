@@ -1,11 +1,35 @@
 #include "mesh.hpp"
 
+#include <cmath>
+
 namespace lavander
 {
 
     Mesh::Mesh(c_device& dev, const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices) : buffers(std::make_unique<c_buffers>(dev, reinterpret_cast<const std::vector<Vertex>&>(const_cast<std::vector<Vertex3D>&>(vertices)), indices))
     {
+        uvDensity_ = ComputeUvDensity(vertices, indices);
+    }
+
+    float Mesh::ComputeUvDensity(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices)
+    {
+        //ratio of total uv area to total surface area, so sqrt gives uv units per world unit
+        double worldArea = 0.0;
+        double uvArea = 0.0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const Vertex3D& a = vertices[indices[i]];
+            const Vertex3D& b = vertices[indices[i + 1]];
+            const Vertex3D& c = vertices[indices[i + 2]];
+
+            worldArea += 0.5 * glm::length(glm::cross(b.pos - a.pos, c.pos - a.pos));
+
+            glm::vec2 e1 = b.uv - a.uv;
+            glm::vec2 e2 = c.uv - a.uv;
+            uvArea += 0.5 * std::abs(e1.x * e2.y - e1.y * e2.x);
+        }
 
+        if (worldArea <= 0.0 || uvArea <= 0.0) return 1.0f;
+        return float(std::sqrt(uvArea / worldArea));
     }
 
     std::shared_ptr<Mesh> Mesh::MakeCube(c_device& dev)
@@ -14,7 +14,13 @@ namespace lavander
 
         static std::shared_ptr<Mesh> MakeCube(c_device& dev);
 
+        //uv units per model space unit, measured at import for texture streaming
+        float uvDensity() const { return uvDensity_; }
+
     private:
+        static float ComputeUvDensity(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices);
+
         std::unique_ptr<c_buffers> buffers;
+        float uvDensity_ = 1.0f;
     };
 }
@@ -0,0 +1,168 @@
+#include "mip_chain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LAVANDER_MIP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace lavander
+{
+    namespace
+    {
+        constexpr int kEncodeLutSize = 4096;
+
+        struct ColorLuts
+        {
+            float   srgbToLinear[256];
+            float   unormToFloat[256];
+            uint8_t linearToSrgb[kEncodeLutSize];
+
+            ColorLuts()
+            {
+                for (int i = 0; i < 256; i++)
+                {
+                    float c = i / 255.0f;
+                    srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                    unormToFloat[i] = c;
+                }
+                for (int i = 0; i < kEncodeLutSize; i++)
+                {
+                    float l = i / float(kEncodeLutSize - 1);
+                    float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                    linearToSrgb[i] = uint8_t(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        };
+
+        const ColorLuts& luts()
+        {
+            static ColorLuts l;
+            return l;
+        }
+
+        inline uint8_t encodeUnorm(float v)
+        {
+            return uint8_t(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+
+        inline uint8_t encodeSrgb(float v)
+        {
+            int idx = int(std::clamp(v, 0.0f, 1.0f) * (kEncodeLutSize - 1) + 0.5f);
+            return luts().linearToSrgb[idx];
+        }
+
+        //average of 4 rgba float pixels
+        inline void average4(const float* a, const float* b, const float* c, const float* d, float* out)
+        {
+#if LAVANDER_MIP_SSE2
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)), _mm_add_ps(_mm_loadu_ps(c), _mm_loadu_ps(d)));
+            _mm_storeu_ps(out, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+            for (int i = 0; i < 4; i++) out[i] = (a[i] + b[i] + c[i] + d[i]) * 0.25f;
+#endif
+        }
+    }
+
+    uint32_t MipChain::LevelCount(uint32_t width, uint32_t height)
+    {
+        uint32_t levels = 1;
+        uint32_t size = std::max(width, height);
+        while (size > 1)
+        {
+            size >>= 1;
+            levels++;
+        }
+        return levels;
+    }
+
+    MipChain MipChain::Single(const uint8_t* rgba, uint32_t width, uint32_t height)
+    {
+        MipChain chain;
+        Level level{ width, height, 0, size_t(width) * height * 4 };
+        chain.levels.push_back(level);
+        chain.data.assign(rgba, rgba + level.size);
+        return chain;
+    }
+
+    MipChain MipChain::Generate(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb)
+    {
+        MipChain chain;
+        const uint32_t count = LevelCount(width, height);
+
+        size_t total = 0;
+        uint32_t w = width, h = height;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Level level{ w, h, total, size_t(w) * h * 4 };
+            chain.levels.push_back(level);
+            total += level.size;
+            w = std::max(1u, w / 2);
+            h = std::max(1u, h / 2);
+        }
+
+        chain.data.resize(total);
+        std::memcpy(chain.data.data(), rgba, chain.levels[0].size);
+
+        //filter from a float copy of the previous level so quantization error doesn't pile up down the chain
+        const ColorLuts& l = luts();
+        const float* colorLut = srgb ? l.srgbToLinear : l.unormToFloat;
+
+        std::vector<float> src(size_t(width) * height * 4);
+        for (size_t i = 0; i < size_t(width) * height; i++)
+        {
+            src[i * 4 + 0] = colorLut[rgba[i * 4 + 0]];
+            src[i * 4 + 1] = colorLut[rgba[i * 4 + 1]];
+            src[i * 4 + 2] = colorLut[rgba[i * 4 + 2]];
+            src[i * 4 + 3] = l.unormToFloat[rgba[i * 4 + 3]];
+        }
+
+        std::vector<float> dst;
+        for (uint32_t li = 1; li < count; li++)
+        {
+            const Level& prev = chain.levels[li - 1];
+            const Level& cur = chain.levels[li];
+            dst.resize(size_t(cur.width) * cur.height * 4);
+
+            uint8_t* out = chain.data.data() + cur.offset;
+            for (uint32_t y = 0; y < cur.height; y++)
+            {
+                //clamp so odd / 1 texel wide levels still filter correctly
+                uint32_t y0 = std::min(y * 2, prev.height - 1);
+                uint32_t y1 = std::min(y * 2 + 1, prev.height - 1);
+                const float* row0 = src.data() + size_t(y0) * prev.width * 4;
+                const float* row1 = src.data() + size_t(y1) * prev.width * 4;
+
+                for (uint32_t x = 0; x < cur.width; x++)
+                {
+                    uint32_t x0 = std::min(x * 2, prev.width - 1);
+                    uint32_t x1 = std::min(x * 2 + 1, prev.width - 1);
+
+                    float* px = dst.data() + (size_t(y) * cur.width + x) * 4;
+                    average4(row0 + x0 * 4, row0 + x1 * 4, row1 + x0 * 4, row1 + x1 * 4, px);
+
+                    uint8_t* o = out + (size_t(y) * cur.width + x) * 4;
+                    if (srgb)
+                    {
+                        o[0] = encodeSrgb(px[0]);
+                        o[1] = encodeSrgb(px[1]);
+                        o[2] = encodeSrgb(px[2]);
+                    }
+                    else
+                    {
+                        o[0] = encodeUnorm(px[0]);
+                        o[1] = encodeUnorm(px[1]);
+                        o[2] = encodeUnorm(px[2]);
+                    }
+                    o[3] = encodeUnorm(px[3]);
+                }
+            }
+            src.swap(dst);
+        }
+
+        return chain;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace lavander
+{
+    // CPU generated RGBA8 mip chain, all levels packed back to back (level 0 first)
+    // so the whole chain can go through a single staging buffer.
+    struct MipChain
+    {
+        struct Level
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            size_t   offset = 0;
+            size_t   size = 0;
+        };
+
+        std::vector<Level>   levels;
+        std::vector<uint8_t> data;
+
+        //2x2 box filter per level, averaged in linear space when srgb is set (alpha is always linear)
+        static MipChain Generate(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb);
+
+        static MipChain Single(const uint8_t* rgba, uint32_t width, uint32_t height);
+
+        static uint32_t LevelCount(uint32_t width, uint32_t height);
+    };
+}
@@ -1,5 +1,6 @@
 #include "pipeline.hpp"
 #include "buffers.hpp"
+#include "render_stats.hpp"
 
 #include <fstream>
 #include <stdexcept>
@@ -19,11 +20,24 @@ namespace lavander
         createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
     }
 
+    c_pipeline::c_pipeline(
+        c_device& device,
+        VkShaderModule vertModule,
+        VkShaderModule fragModule,
+        const PipelineConfigInfo& configInfo) :
+        device{ device }, ownsModules{ false }
+    {
+        createGraphicsPipeline(vertModule, fragModule, configInfo);
+    }
+
     c_pipeline::~c_pipeline()
     {
-        vkDestroyShaderModule(device.device(), vertShaderModule, nullptr);
-        vkDestroyShaderModule(device.device(), fragShaderModule, nullptr);
-        vkDestroyPipeline(device.device(), graphicsPipeline, nullptr);
+        if (ownsModules)
+        {
+            vkDestroyShaderModule(device.device(), vertShaderModule, c_device::allocator());
+            vkDestroyShaderModule(device.device(), fragShaderModule, c_device::allocator());
+        }
+        vkDestroyPipeline(device.device(), graphicsPipeline, c_device::allocator());
     }
 
     std::vector<char> c_pipeline::readFile(const std::string& filepath)
@@ -50,26 +64,50 @@ namespace lavander
         const std::string& fragFilepath,
         const PipelineConfigInfo& cfg)
     {
-        assert(cfg.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline: no pipelineLayout");
-        assert(cfg.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no renderPass");
-
         auto vertCode = readFile(vertFilepath);
         auto fragCode = readFile(fragFilepath);
 
         createShaderModule(vertCode, &vertShaderModule);
         createShaderModule(fragCode, &fragShaderModule);
 
+        createGraphicsPipeline(vertShaderModule, fragShaderModule, cfg);
+    }
+
+    void c_pipeline::createGraphicsPipeline(
+        VkShaderModule vertModule,
+        VkShaderModule fragModule,
+        const PipelineConfigInfo& cfg)
+    {
+        assert(cfg.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline: no pipelineLayout");
+        assert(cfg.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no renderPass");
+
         VkPipelineShaderStageCreateInfo shaderStages[2]{};
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-        shaderStages[0].module = vertShaderModule;
+        shaderStages[0].module = vertModule;
         shaderStages[0].pName = "main";
 
         shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        shaderStages[1].module = fragShaderModule;
+        shaderStages[1].module = fragModule;
         shaderStages[1].pName = "main";
 
+        //one VkBool32 per feature bit, constant_id = bit index
+        VkBool32 featureValues[SHADER_FEATURE_COUNT];
+        VkSpecializationMapEntry featureEntries[SHADER_FEATURE_COUNT];
+        for (uint32_t i = 0; i < SHADER_FEATURE_COUNT; i++)
+        {
+            featureValues[i] = (cfg.features >> i) & 1u;
+            featureEntries[i] = { i, uint32_t(i * sizeof(VkBool32)), sizeof(VkBool32) };
+        }
+
+        VkSpecializationInfo specialization{};
+        specialization.mapEntryCount = SHADER_FEATURE_COUNT;
+        specialization.pMapEntries = featureEntries;
+        specialization.dataSize = sizeof(featureValues);
+        specialization.pData = featureValues;
+        shaderStages[1].pSpecializationInfo = &specialization;
+
         //vertex input
         VkPipelineVertexInputStateCreateInfo vertexInputInfo = cfg.vertexInputInfo;
         vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(cfg.bindingDescriptions.size());
@@ -77,13 +115,22 @@ namespace lavander
         vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(cfg.attributeDescriptions.size());
         vertexInputInfo.pVertexAttributeDescriptions = cfg.attributeDescriptions.data();
 
-        //viewport and scissor
+        //viewport and scissor, only the counts, the values are dynamic
         VkPipelineViewportStateCreateInfo viewportInfo{};
         viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
         viewportInfo.viewportCount = 1;
-        viewportInfo.pViewports = &cfg.viewport;
+        viewportInfo.pViewports = nullptr;
         viewportInfo.scissorCount = 1;
-        viewportInfo.pScissors = &cfg.scissor;
+        viewportInfo.pScissors = nullptr;
+
+        VkPipelineDynamicStateCreateInfo dynamicStateInfo{};
+        dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(cfg.dynamicStateEnables.size());
+        dynamicStateInfo.pDynamicStates = cfg.dynamicStateEnables.data();
+
+        //configs get copied around, point blending at this config's own attachment
+        VkPipelineColorBlendStateCreateInfo colorBlendInfo = cfg.colorBlendInfo;
+        colorBlendInfo.pAttachments = &cfg.colorBlendAttachment;
 
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -94,16 +141,16 @@ namespace lavander
         pipelineInfo.pViewportState = &viewportInfo;
         pipelineInfo.pRasterizationState = &cfg.rasterizationInfo;
         pipelineInfo.pMultisampleState = &cfg.multisampleInfo;
-        pipelineInfo.pColorBlendState = &cfg.colorBlendInfo;
+        pipelineInfo.pColorBlendState = &colorBlendInfo;
         pipelineInfo.pDepthStencilState = &cfg.depthStencilInfo;
-        pipelineInfo.pDynamicState = nullptr;
+        pipelineInfo.pDynamicState = &dynamicStateInfo;
         pipelineInfo.layout = cfg.pipelineLayout;
         pipelineInfo.renderPass = cfg.renderPass;
         pipelineInfo.subpass = cfg.subpass;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineInfo.basePipelineIndex = -1;
 
-        if (vkCreateGraphicsPipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+        if (vkCreateGraphicsPipelines(device.device(), device.pipelineCache(), 1, &pipelineInfo, c_device::allocator(), &graphicsPipeline) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create graphics pipeline");
         }
@@ -116,7 +163,7 @@ namespace lavander
         createInfo.codeSize = code.size();
         createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
-        if (vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
+        if (vkCreateShaderModule(device.device(), &createInfo, c_device::allocator(), shaderModule) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create shader module");
         }
@@ -125,9 +172,10 @@ namespace lavander
     void c_pipeline::bind(VkCommandBuffer commandBuffer)
     {
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+        RenderStats::Get().countPipelineBind();
     }
 
-    PipelineConfigInfo c_pipeline::defaultPipelineConfigInfo(uint32_t width, uint32_t height)
+    PipelineConfigInfo c_pipeline::defaultPipelineConfigInfo()
     {
         PipelineConfigInfo cfg{};
 
@@ -136,16 +184,8 @@ namespace lavander
         cfg.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
         cfg.inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
 
-        //viewport and scissor
-        cfg.viewport.x = 0.0f;
-        cfg.viewport.y = 0.0f;
-        cfg.viewport.width = static_cast<float>(width);
-        cfg.viewport.height = static_cast<float>(height);
-        cfg.viewport.minDepth = 0.0f;
-        cfg.viewport.maxDepth = 1.0f;
-
-        cfg.scissor.offset = { 0, 0 };
-        cfg.scissor.extent = { width, height };
+        //viewport and scissor are set per frame so pipelines don't depend on the target size
+        cfg.dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
 
         //rasterizer
         cfg.rasterizationInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
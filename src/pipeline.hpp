@@ -8,10 +8,18 @@
 
 namespace lavander {
 
+    // Optional shader features, each maps to a fragment specialization constant
+    // (constant_id = bit index) so a variant only contains the paths it uses.
+    enum ShaderFeature : uint32_t
+    {
+        SHADER_FEATURE_TEXTURE    = 1u << 0, // sample the material texture (USE_TEXTURE)
+        SHADER_FEATURE_LIT        = 1u << 1, // directional lighting (LIT)
+        SHADER_FEATURE_ALPHA_TEST = 1u << 2, // discard below 0.5 alpha (ALPHA_TEST)
+        SHADER_FEATURE_COUNT      = 3
+    };
+
     struct PipelineConfigInfo 
     {
-        VkViewport viewport;
-        VkRect2D scissor;
         VkPipelineViewportStateCreateInfo viewportInfo;
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
         VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -26,6 +34,10 @@ namespace lavander {
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
         std::vector<VkVertexInputBindingDescription>   bindingDescriptions{};
+        //viewport and scissor are always dynamic, set them after binding
+        std::vector<VkDynamicState> dynamicStateEnables{};
+        //ShaderFeature bits, passed as specialization constants
+        uint32_t features = 0;
 
     };
 
@@ -36,27 +48,39 @@ namespace lavander {
             const std::string& vertFilepath, 
             const std::string& fragFilepath, 
             const PipelineConfigInfo& configInfo);
+        //builds from modules owned by someone else (PipelineLibrary)
+        c_pipeline(
+            c_device& device,
+            VkShaderModule vertModule,
+            VkShaderModule fragModule,
+            const PipelineConfigInfo& configInfo);
         ~c_pipeline();
         c_pipeline(const c_pipeline&) = delete;
         void operator=(const c_pipeline&) = delete;
 
         void bind(VkCommandBuffer commandBuffer);
+        VkPipeline handle() const { return graphicsPipeline; }
 
-        static PipelineConfigInfo defaultPipelineConfigInfo(uint32_t width, uint32_t height);
+        static PipelineConfigInfo defaultPipelineConfigInfo();
+        static std::vector<char> readFile(const std::string& filepath);
 
         private:
-        
-        static std::vector<char> readFile(const std::string& filepath);
+
         void createGraphicsPipeline(
             const std::string& vertFilepath, 
             const std::string& fragFilepath, 
             const PipelineConfigInfo& configInfo);
+        void createGraphicsPipeline(
+            VkShaderModule vertModule,
+            VkShaderModule fragModule,
+            const PipelineConfigInfo& configInfo);
 
         void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
 
         c_device& device;
         VkPipeline graphicsPipeline;
-        VkShaderModule vertShaderModule;
-        VkShaderModule fragShaderModule;
+        VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+        VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+        bool ownsModules = true;
     };
 }
\ No newline at end of file
@@ -0,0 +1,367 @@
+#include "pipeline_library.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+namespace lavander
+{
+    namespace
+    {
+        constexpr uint64_t kFnvOffset = 1469598103934665603ull;
+        constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+        struct Hasher
+        {
+            uint64_t h = kFnvOffset;
+
+            void bytes(const void* data, size_t size)
+            {
+                const unsigned char* p = static_cast<const unsigned char*>(data);
+                for (size_t i = 0; i < size; i++)
+                {
+                    h ^= p[i];
+                    h *= kFnvPrime;
+                }
+            }
+
+            template<typename T>
+            void value(const T& v) { bytes(&v, sizeof(T)); }
+        };
+    }
+
+    PipelineLibrary::PipelineLibrary(c_device& device) : device(device)
+    {
+        //leave most cores to the frame, compiles are latency tolerant
+        unsigned count = std::clamp(std::thread::hardware_concurrency() / 4, 1u, 2u);
+        for (unsigned i = 0; i < count; i++)
+        {
+            workers.emplace_back(&PipelineLibrary::backgroundWorker, this);
+        }
+    }
+
+    PipelineLibrary::~PipelineLibrary()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            queue.clear();
+        }
+        queueCv.notify_all();
+        for (auto& worker : workers) worker.join();
+
+        pipelines.clear();
+        for (auto& [hash, module] : modules)
+        {
+            vkDestroyShaderModule(device.device(), module, c_device::allocator());
+        }
+    }
+
+    const PipelineLibrary::Module& PipelineLibrary::loadShader(const std::string& path)
+    {
+        auto it = shadersByPath.find(path);
+        if (it != shadersByPath.end()) return it->second;
+
+        std::vector<char> code = c_pipeline::readFile(path);
+
+        Hasher hasher;
+        hasher.bytes(code.data(), code.size());
+
+        //the same SPIR-V under another path shares the module
+        auto mod = modules.find(hasher.h);
+        if (mod == modules.end())
+        {
+            VkShaderModuleCreateInfo createInfo{};
+            createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            createInfo.codeSize = code.size();
+            createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+            VkShaderModule module;
+            if (vkCreateShaderModule(device.device(), &createInfo, c_device::allocator(), &module) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create shader module: " + path);
+            }
+            mod = modules.emplace(hasher.h, module).first;
+        }
+
+        return shadersByPath.emplace(path, Module{ hasher.h, mod->second }).first->second;
+    }
+
+    uint64_t PipelineLibrary::hashDesc(const PipelineDesc& desc, uint64_t vertHash, uint64_t fragHash) const
+    {
+        const PipelineConfigInfo& c = desc.config;
+        Hasher h;
+
+        h.value(vertHash);
+        h.value(fragHash);
+        h.value(c.features);
+
+        for (const auto& b : c.bindingDescriptions)
+        {
+            h.value(b.binding); h.value(b.stride); h.value(b.inputRate);
+        }
+        for (const auto& a : c.attributeDescriptions)
+        {
+            h.value(a.location); h.value(a.binding); h.value(a.format); h.value(a.offset);
+        }
+
+        h.value(c.inputAssemblyInfo.topology);
+        h.value(c.inputAssemblyInfo.primitiveRestartEnable);
+
+        for (VkDynamicState s : c.dynamicStateEnables) h.value(s);
+
+        const auto& r = c.rasterizationInfo;
+        h.value(r.depthClampEnable); h.value(r.rasterizerDiscardEnable); h.value(r.polygonMode);
+        h.value(r.cullMode); h.value(r.frontFace); h.value(r.depthBiasEnable);
+        h.value(r.depthBiasConstantFactor); h.value(r.depthBiasClamp); h.value(r.depthBiasSlopeFactor);
+        h.value(r.lineWidth);
+
+        const auto& m = c.multisampleInfo;
+        h.value(m.rasterizationSamples); h.value(m.sampleShadingEnable); h.value(m.minSampleShading);
+        h.value(m.alphaToCoverageEnable); h.value(m.alphaToOneEnable);
+
+        const auto& b = c.colorBlendAttachment;
+        h.value(b.blendEnable); h.value(b.srcColorBlendFactor); h.value(b.dstColorBlendFactor); h.value(b.colorBlendOp);
+        h.value(b.srcAlphaBlendFactor); h.value(b.dstAlphaBlendFactor); h.value(b.alphaBlendOp); h.value(b.colorWriteMask);
+        h.value(c.colorBlendInfo.logicOpEnable); h.value(c.colorBlendInfo.logicOp);
+        h.value(c.colorBlendInfo.attachmentCount); h.value(c.colorBlendInfo.blendConstants);
+
+        const auto& d = c.depthStencilInfo;
+        h.value(d.depthTestEnable); h.value(d.depthWriteEnable); h.value(d.depthCompareOp);
+        h.value(d.depthBoundsTestEnable); h.value(d.stencilTestEnable); h.value(d.front); h.value(d.back);
+        h.value(d.minDepthBounds); h.value(d.maxDepthBounds);
+
+        //pipelines are only valid with a compatible pass, key on the pass itself
+        h.value(c.pipelineLayout);
+        h.value(c.renderPass);
+        h.value(c.subpass);
+
+        return h.h;
+    }
+
+    c_pipeline& PipelineLibrary::get(const PipelineDesc& desc)
+    {
+        uint64_t key;
+        VkShaderModule vert, frag;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            const Module& v = loadShader(desc.vertPath);
+            const Module& f = loadShader(desc.fragPath);
+            key = hashDesc(desc, v.hash, f.hash);
+
+            auto it = pipelines.find(key);
+            if (it != pipelines.end())
+            {
+                hits_++;
+                return *it->second;
+            }
+            vert = v.module;
+            frag = f.module;
+        }
+
+        //compile unlocked so lookups and the background workers aren't stuck behind it,
+        //modules live until the library goes away
+        auto start = std::chrono::steady_clock::now();
+        auto pipeline = std::make_unique<c_pipeline>(device, vert, frag, desc.config);
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        inlineCompileMs += ms;
+        //another thread may have built the same state meanwhile, theirs wins and ours is dropped
+        return *pipelines.emplace(key, std::move(pipeline)).first->second;
+    }
+
+    c_pipeline* PipelineLibrary::request(const PipelineDesc& desc, uint64_t* keyOut)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            const Module& vert = loadShader(desc.vertPath);
+            const Module& frag = loadShader(desc.fragPath);
+            uint64_t key = hashDesc(desc, vert.hash, frag.hash);
+            if (keyOut) *keyOut = key;
+
+            auto it = pipelines.find(key);
+            if (it != pipelines.end())
+            {
+                hits_++;
+                return it->second.get();
+            }
+            fellBack = true;
+            backgroundBusy = true;
+            if (!queued.insert(key).second) return nullptr;
+
+            queue.push_back({ key, vert.module, frag.module, desc.config });
+        }
+        queueCv.notify_one();
+        return nullptr;
+    }
+
+    c_pipeline* PipelineLibrary::find(uint64_t key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pipelines.find(key);
+        if (it == pipelines.end())
+        {
+            fellBack = true;
+            return nullptr;
+        }
+        return it->second.get();
+    }
+
+    c_pipeline& PipelineLibrary::requestOr(const PipelineDesc& desc, c_pipeline& fallback)
+    {
+        c_pipeline* pipeline = request(desc);
+        return pipeline ? *pipeline : fallback;
+    }
+
+    size_t PipelineLibrary::pendingCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queued.size();
+    }
+
+    void PipelineLibrary::backgroundWorker()
+    {
+        for (;;)
+        {
+            BackgroundJob job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queueCv.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (stopping) return;
+
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            std::unique_ptr<c_pipeline> pipeline;
+            try
+            {
+                pipeline = std::make_unique<c_pipeline>(device, job.vert, job.frag, job.config);
+            }
+            catch (const std::exception& e)
+            {
+                //leave it queued so it isn't retried every frame, draws keep using the fallback
+                std::cerr << "background pipeline compile failed: " << e.what() << std::endl;
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            pipelines.emplace(job.key, std::move(pipeline));
+            queued.erase(job.key);
+            backgroundCompiled_++;
+            backgroundBusy = true; // finished during this frame, it still ran alongside it
+        }
+    }
+
+    void PipelineLibrary::endFrame(float frameMs, float budgetMs)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (frameMs > budgetMs)
+        {
+            if (inlineCompileMs > 0.0f) compileHitches_++;
+            if (fellBack || backgroundBusy || !queued.empty()) fallbackHitches_++;
+        }
+        inlineCompileMs = 0.0f;
+        fellBack = false;
+        backgroundBusy = false;
+    }
+
+    void PipelineLibrary::compileAll(const std::vector<PipelineDesc>& descs)
+    {
+        struct Job
+        {
+            uint64_t key;
+            VkShaderModule vert;
+            VkShaderModule frag;
+            const PipelineConfigInfo* config;
+            std::unique_ptr<c_pipeline> result;
+        };
+
+        //shaders load and hash on this thread, only the driver compiles go wide
+        std::vector<Job> jobs;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const PipelineDesc& desc : descs)
+            {
+                const Module& vert = loadShader(desc.vertPath);
+                const Module& frag = loadShader(desc.fragPath);
+                uint64_t key = hashDesc(desc, vert.hash, frag.hash);
+
+                bool queued = std::any_of(jobs.begin(), jobs.end(), [key](const Job& j) { return j.key == key; });
+                if (queued || pipelines.count(key))
+                {
+                    hits_++;
+                    continue;
+                }
+                jobs.push_back({ key, vert.module, frag.module, &desc.config, nullptr });
+            }
+        }
+        if (jobs.empty()) return;
+
+        std::atomic<size_t> next{ 0 };
+        std::exception_ptr failure;
+        std::mutex failureMutex;
+        auto worker = [&]()
+        {
+            for (size_t i = next++; i < jobs.size(); i = next++)
+            {
+                try
+                {
+                    jobs[i].result = std::make_unique<c_pipeline>(device, jobs[i].vert, jobs[i].frag, *jobs[i].config);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(failureMutex);
+                    if (!failure) failure = std::current_exception();
+                }
+            }
+        };
+
+        const size_t threadCount = std::min<size_t>(jobs.size(), std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < threadCount; t++) threads.emplace_back(worker);
+        worker();
+        for (auto& th : threads) th.join();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Job& job : jobs)
+        {
+            if (job.result) pipelines.emplace(job.key, std::move(job.result));
+        }
+        if (failure) std::rethrow_exception(failure);
+    }
+
+    PipelineVariantSet::PipelineVariantSet(PipelineLibrary& library, uint32_t baseFeatures, Describe describe)
+        : library(library), baseFeatures(baseFeatures), describe(std::move(describe))
+    {
+        variants[baseFeatures] = &library.get(this->describe(baseFeatures));
+    }
+
+    c_pipeline& PipelineVariantSet::get(uint32_t features)
+    {
+        //requested once, poll() picks it up when built
+        c_pipeline*& slot = variants[features];
+        if (!slot && !pending[features])
+        {
+            slot = library.request(describe(features), &pending[features]);
+            if (slot) pending[features] = 0;
+        }
+        return slot ? *slot : base();
+    }
+
+    void PipelineVariantSet::poll()
+    {
+        for (size_t i = 0; i < variants.size(); i++)
+        {
+            if (!pending[i]) continue;
+            variants[i] = library.find(pending[i]);
+            if (variants[i]) pending[i] = 0;
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "pipeline.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace lavander
+{
+    // everything that makes a graphics pipeline distinct
+    struct PipelineDesc
+    {
+        std::string vertPath;
+        std::string fragPath;
+        PipelineConfigInfo config;
+    };
+
+    // Owns every graphics pipeline. Pipelines are keyed by a hash of their full state
+    // (shader contents, vertex layout, raster/blend/depth/dynamic state, layout and render pass),
+    // so asking twice for the same description returns the same pipeline. Shader modules
+    // are shared by content hash, and compileAll() builds a batch on worker threads.
+    //
+    // At runtime request() never compiles on the calling thread: a missing pipeline is
+    // queued for the background workers and the caller draws with a fallback meanwhile.
+    class PipelineLibrary
+    {
+    public:
+        explicit PipelineLibrary(c_device& device);
+        ~PipelineLibrary();
+
+        PipelineLibrary(const PipelineLibrary&) = delete;
+        PipelineLibrary& operator=(const PipelineLibrary&) = delete;
+
+        //returns the existing pipeline for this state or creates it on the calling thread
+        c_pipeline& get(const PipelineDesc& desc);
+
+        //creates every missing pipeline in the list in parallel, duplicates are built once
+        void compileAll(const std::vector<PipelineDesc>& descs);
+
+        //the pipeline if it's built, otherwise queues it in the background and returns nullptr;
+        //key receives the pipeline's key either way, for polling with find() later
+        c_pipeline* request(const PipelineDesc& desc, uint64_t* key = nullptr);
+        //a pipeline by the key request() handed out, nullptr while it's still compiling
+        c_pipeline* find(uint64_t key);
+        c_pipeline& requestOr(const PipelineDesc& desc, c_pipeline& fallback);
+
+        //frame bookkeeping for the hitch counters, frameMs is the frame recorded since the last
+        //call. A frame over budget counts as
+        //  compile hitch:  it compiled a pipeline inline (through get())
+        //  fallback hitch: background workers were compiling, or a draw used a fallback because
+        //                  its pipeline wasn't ready (request()/find() came back empty)
+        //A frame can count as both. Background compiles mostly show up as fallback hitches, they
+        //compete for CPU and driver locks with the render thread.
+        void endFrame(float frameMs, float budgetMs = 1000.0f / 60.0f);
+
+        size_t pipelineCount() const { return pipelines.size(); }
+        size_t shaderModuleCount() const { return modules.size(); }
+        uint64_t hits() const { return hits_; }
+        size_t pendingCount();
+        uint64_t backgroundCompiled() const { return backgroundCompiled_; }
+        uint64_t compileHitches() const { return compileHitches_; }
+        uint64_t fallbackHitches() const { return fallbackHitches_; }
+
+    private:
+        struct Module
+        {
+            uint64_t hash;
+            VkShaderModule module;
+        };
+
+        struct BackgroundJob
+        {
+            uint64_t key;
+            VkShaderModule vert;
+            VkShaderModule frag;
+            PipelineConfigInfo config;
+        };
+
+        const Module& loadShader(const std::string& path);
+        uint64_t hashDesc(const PipelineDesc& desc, uint64_t vertHash, uint64_t fragHash) const;
+        void backgroundWorker();
+
+        c_device& device;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, Module> shadersByPath;
+        std::unordered_map<uint64_t, VkShaderModule> modules;
+        std::unordered_map<uint64_t, std::unique_ptr<c_pipeline>> pipelines;
+        uint64_t hits_ = 0;
+
+        std::vector<std::thread> workers;
+        std::condition_variable queueCv;
+        std::deque<BackgroundJob> queue;
+        std::unordered_set<uint64_t> queued; // queued or being built
+        bool stopping = false;
+        uint64_t backgroundCompiled_ = 0;
+
+        float inlineCompileMs = 0.0f; // this frame
+        bool fellBack = false;        // this frame, a request or find came back empty
+        bool backgroundBusy = false;  // this frame, a background job was queued or running
+        uint64_t compileHitches_ = 0;
+        uint64_t fallbackHitches_ = 0;
+    };
+
+    // One renderer's pipeline in all its SHADER_FEATURE_* variants. The base variant is built
+    // up front; the others are requested from the library on first use and drawn with the
+    // base one until their background compile lands.
+    class PipelineVariantSet
+    {
+    public:
+        using Describe = std::function<PipelineDesc(uint32_t features)>;
+
+        PipelineVariantSet(PipelineLibrary& library, uint32_t baseFeatures, Describe describe);
+
+        //the variant for these features, the base one while it's still compiling
+        c_pipeline& get(uint32_t features);
+        c_pipeline& base() { return *variants[baseFeatures]; }
+        //picks up finished variants, once per draw() instead of per object
+        void poll();
+
+    private:
+        PipelineLibrary& library;
+        uint32_t baseFeatures;
+        Describe describe;
+        std::array<c_pipeline*, 1u << SHADER_FEATURE_COUNT> variants{};
+        //library keys of variants still compiling
+        std::array<uint64_t, 1u << SHADER_FEATURE_COUNT> pending{};
+    };
+}
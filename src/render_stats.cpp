@@ -0,0 +1,102 @@
+#include "render_stats.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <imgui.h>
+
+namespace lavander
+{
+    RenderStats& RenderStats::Get()
+    {
+        static RenderStats stats;
+        return stats;
+    }
+
+    void RenderStats::setWindow(uint32_t frames)
+    {
+        windowSize = std::max(1u, frames);
+        history.clear();
+        historyNext = 0;
+    }
+
+    void RenderStats::endFrame(uint64_t frameNumber, float frameMs)
+    {
+        auto take = [](std::atomic<uint64_t>& counter) { return counter.exchange(0, std::memory_order_relaxed); };
+        last.drawCalls = take(current.drawCalls);
+        last.instances = take(current.instances);
+        last.triangles = take(current.triangles);
+        last.pipelineBinds = take(current.pipelineBinds);
+        last.descriptorBinds = take(current.descriptorBinds);
+        last.pushConstants = take(current.pushConstants);
+        last.bufferBytesUploaded = take(current.bufferBytesUploaded);
+        last.textureBytesUploaded = take(current.textureBytesUploaded);
+        lastMs = frameMs;
+
+        if (history.size() < windowSize) history.push_back(frameMs);
+        else history[historyNext] = frameMs;
+        historyNext = (historyNext + 1) % windowSize;
+
+        //a sort of a few hundred floats, cheaper than keeping an order statistic tree
+        sorted.assign(history.begin(), history.end());
+        std::sort(sorted.begin(), sorted.end());
+        auto at = [this](float p) { return sorted[std::min(sorted.size() - 1, size_t(p * float(sorted.size() - 1) + 0.5f))]; };
+
+        float sum = 0.0f;
+        for (float ms : sorted) sum += ms;
+        times.avgMs = sum / float(sorted.size());
+        times.p50Ms = at(0.50f);
+        times.p95Ms = at(0.95f);
+        times.p99Ms = at(0.99f);
+        times.maxMs = sorted.back();
+        times.frames = uint32_t(sorted.size());
+
+        if (csv.is_open())
+        {
+            csv << frameNumber << ',' << frameMs << ','
+                << last.drawCalls << ',' << last.instances << ',' << last.triangles << ','
+                << last.pipelineBinds << ',' << last.descriptorBinds << ',' << last.pushConstants << ','
+                << last.bufferBytesUploaded << ',' << last.textureBytesUploaded << ','
+                << times.p50Ms << ',' << times.p95Ms << ',' << times.p99Ms << '\n';
+        }
+    }
+
+    bool RenderStats::startCsv(const std::string& path)
+    {
+        stopCsv();
+        csv.open(path, std::ios::trunc);
+        if (!csv) return false;
+
+        csv << "frame,frame_ms,draw_calls,instances,triangles,pipeline_binds,descriptor_binds,push_constants,"
+            "buffer_bytes_uploaded,texture_bytes_uploaded,p50_ms,p95_ms,p99_ms\n";
+        return true;
+    }
+
+    void RenderStats::stopCsv()
+    {
+        if (csv.is_open()) csv.close();
+    }
+
+    void RenderStats::drawOverlay(float x, float y)
+    {
+        char text[512];
+        std::snprintf(text, sizeof(text),
+            "%.2f ms  p50 %.2f  p95 %.2f  p99 %.2f\n"
+            "draws %llu  instances %llu  tris %llu\n"
+            "pipelines %llu  sets %llu  push %llu\n"
+            "upload buf %.1f KB  tex %.1f KB",
+            lastMs, times.p50Ms, times.p95Ms, times.p99Ms,
+            (unsigned long long)last.drawCalls, (unsigned long long)last.instances, (unsigned long long)last.triangles,
+            (unsigned long long)last.pipelineBinds, (unsigned long long)last.descriptorBinds, (unsigned long long)last.pushConstants,
+            last.bufferBytesUploaded / 1024.0, last.textureBytesUploaded / 1024.0);
+
+        //right aligned to x
+        ImVec2 size = ImGui::CalcTextSize(text);
+        ImVec2 min(x - size.x - 12.0f, y);
+        ImVec2 max(x, y + size.y + 8.0f);
+
+        ImDrawList* dl = ImGui::GetWindowDrawList();
+        dl->AddRectFilled(min, max, IM_COL32(0, 0, 0, 160), 4.0f);
+        dl->AddText(ImVec2(min.x + 6.0f, min.y + 4.0f), IM_COL32_WHITE, text);
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace lavander
+{
+    struct FrameStats
+    {
+        uint64_t drawCalls = 0;
+        uint64_t instances = 0;
+        uint64_t triangles = 0;
+        uint64_t pipelineBinds = 0;
+        uint64_t descriptorBinds = 0;
+        uint64_t pushConstants = 0;
+        uint64_t bufferBytesUploaded = 0;
+        uint64_t textureBytesUploaded = 0;
+    };
+
+    struct FrameTimeStats
+    {
+        float avgMs = 0.0f;
+        float p50Ms = 0.0f;
+        float p95Ms = 0.0f;
+        float p99Ms = 0.0f;
+        float maxMs = 0.0f;
+        uint32_t frames = 0; // samples in the window
+    };
+
+    // Per-frame render counters and frame-time percentiles. The recording and upload
+    // paths bump the counters as they go; endFrame() closes the frame, updates the
+    // sliding window and appends a CSV row when logging is on.
+    class RenderStats
+    {
+    public:
+        static RenderStats& Get();
+
+        void countDraw(uint32_t instances, uint64_t triangles)
+        {
+            add(current.drawCalls, 1);
+            add(current.instances, instances);
+            add(current.triangles, triangles * instances);
+        }
+        void countPipelineBind() { add(current.pipelineBinds, 1); }
+        void countDescriptorBind(uint32_t sets = 1) { add(current.descriptorBinds, sets); }
+        void countPushConstants() { add(current.pushConstants, 1); }
+        void countBufferUpload(uint64_t bytes) { add(current.bufferBytesUploaded, bytes); }
+        void countTextureUpload(uint64_t bytes) { add(current.textureBytesUploaded, bytes); }
+
+        //closes the frame, frameMs is the whole frame's wall time
+        void endFrame(uint64_t frameNumber, float frameMs);
+
+        const FrameStats& lastFrame() const { return last; }
+        const FrameTimeStats& frameTimes() const { return times; }
+        float lastFrameMs() const { return lastMs; }
+
+        //frame-time percentiles cover this many of the most recent frames
+        void setWindow(uint32_t frames);
+        uint32_t window() const { return windowSize; }
+
+        //one row per frame: counters, frame time and the window's percentiles
+        bool startCsv(const std::string& path);
+        void stopCsv();
+        bool isLoggingCsv() const { return csv.is_open(); }
+
+        void drawOverlay(float x, float y);
+
+    private:
+        struct Counters
+        {
+            std::atomic<uint64_t> drawCalls{ 0 };
+            std::atomic<uint64_t> instances{ 0 };
+            std::atomic<uint64_t> triangles{ 0 };
+            std::atomic<uint64_t> pipelineBinds{ 0 };
+            std::atomic<uint64_t> descriptorBinds{ 0 };
+            std::atomic<uint64_t> pushConstants{ 0 };
+            std::atomic<uint64_t> bufferBytesUploaded{ 0 };
+            std::atomic<uint64_t> textureBytesUploaded{ 0 };
+        };
+
+        //uploads can come from loader threads, counting stays lock free
+        static void add(std::atomic<uint64_t>& counter, uint64_t n) { counter.fetch_add(n, std::memory_order_relaxed); }
+
+        RenderStats() = default;
+
+        Counters current;
+        FrameStats last;
+        float lastMs = 0.0f;
+
+        uint32_t windowSize = 600;
+        std::vector<float> history;
+        uint32_t historyNext = 0;
+        std::vector<float> sorted;
+        FrameTimeStats times;
+
+        std::ofstream csv;
+    };
+}
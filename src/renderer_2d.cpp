@@ -4,6 +4,8 @@
 #include "component_storage.hpp"
 #include "components.hpp"
 #include "ecs_registry.hpp"
+#include "cpu_profiler.hpp"
+#include "render_stats.hpp"
 
 #include <stdexcept>
 #include <array>
@@ -14,19 +16,20 @@ namespace lavander
 {
 
     Renderer2D::Renderer2D(c_device& device,
+        PipelineLibrary& pipelines,
         VkRenderPass renderPass,
-        VkExtent2D extent,
         VkPipelineLayout layout,
         VkDescriptorSetLayout matLayout,
-        VkDescriptorPool matPool)
+        DescriptorAllocator& matDescriptors)
         : deviceRef(device),
         pipelineLayout(layout),
+        pipelines(pipelines),
         materialSetLayout(matLayout),
-        materialPool(matPool)        // comes from Engine
+        materialDescriptors(matDescriptors)        // comes from Engine
     {
         createQuadBuffers();
-        createPipeline(renderPass, extent);
-        createDefaultTexture();        // uses materialPool + materialSetLayout
+        createPipeline(renderPass);
+        createDefaultTexture();        // uses materialDescriptors + materialSetLayout
     }
 
     void Renderer2D::createQuadBuffers()
@@ -51,15 +54,20 @@ namespace lavander
     {
         defaultWhite = std::make_shared<Texture2D>(deviceRef, 255, 255, 255, 255);
         // allocate once, cache inside Texture2D
-        defaultWhite->allocateDescriptor(materialPool, materialSetLayout);
+        defaultWhite->allocateDescriptor(materialDescriptors, materialSetLayout);
     }
 
-    void Renderer2D::createPipeline(VkRenderPass renderPass, VkExtent2D extent)
+    PipelineDesc Renderer2D::describePipeline(VkRenderPass renderPass, VkPipelineLayout layout, uint32_t features)
     {
-        auto config = c_pipeline::defaultPipelineConfigInfo(extent.width, extent.height);
+        PipelineDesc desc;
+        desc.vertPath = "../../src/shaders/quad_shader.vert.spv";
+        desc.fragPath = "../../src/shaders/quad_shader.frag.spv";
+
+        auto& config = desc.config;
+        config = c_pipeline::defaultPipelineConfigInfo();
         config.renderPass = renderPass;
-        config.pipelineLayout = pipelineLayout;
-        config.colorBlendInfo.pAttachments = &config.colorBlendAttachment;
+        config.pipelineLayout = layout;
+        config.features = features;
 
         // vertex layout
         auto bind = Vertex::getBindingDescription();
@@ -67,18 +75,22 @@ namespace lavander
         config.bindingDescriptions = { bind };
         config.attributeDescriptions = { attrs.begin(), attrs.end() };
 
-        pipeline = std::make_unique<c_pipeline>(
-            deviceRef,
-            "../../src/shaders/quad_shader.vert.spv",
-            "../../src/shaders/quad_shader.frag.spv",
-            config
-        );
+        return desc;
+    }
+
+    void Renderer2D::createPipeline(VkRenderPass rp)
+    {
+        VkPipelineLayout layout = pipelineLayout;
+        variants = std::make_unique<PipelineVariantSet>(pipelines, kBaseFeatures,
+            [rp, layout](uint32_t features) { return describePipeline(rp, layout, features); });
     }
 
     void Renderer2D::draw(VkCommandBuffer cmd, ECSRegistry& registry)
     {
-        pipeline->bind(cmd);
+        PROFILE_SCOPE("Renderer2D::draw");
+        variants->poll();
         quadBuffers->bind(cmd);
+        c_pipeline* bound = nullptr;
 
         auto& spritesByEntity = registry.getAllComponentsOfType<SpriteRenderer>();
         for (auto& [entity, spriteList] : spritesByEntity)
@@ -94,17 +106,26 @@ namespace lavander
                 {
                     // Allocate once if needed, then reuse cached set
                     if (sprite.texture->descriptorSet() == VK_NULL_HANDLE)
-                        sprite.texture->allocateDescriptor(materialPool, materialSetLayout);
+                        sprite.texture->allocateDescriptor(materialDescriptors, materialSetLayout);
 
                     matSet = sprite.texture->descriptorSet();
                 }
 
+                uint32_t features = (sprite.texture ? SHADER_FEATURE_TEXTURE : 0u) | (sprite.alphaTest ? SHADER_FEATURE_ALPHA_TEST : 0u);
+                c_pipeline& p = variants->get(features);
+                if (&p != bound)
+                {
+                    p.bind(cmd);
+                    bound = &p;
+                }
+
                 // Bind material set at set = 1
                 vkCmdBindDescriptorSets(
                     cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
                     pipelineLayout, /*firstSet*/ 1, 1, &matSet,
                     0, nullptr
                 );
+                RenderStats::Get().countDescriptorBind();
 
                 // Draw for each transform on this entity (supports multi-Transform)
                 for (auto& t : *transforms)
@@ -126,6 +147,7 @@ namespace lavander
                         VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                         0, sizeof(PushConst), &pc
                     );
+                    RenderStats::Get().countPushConstants();
 
                     quadBuffers->draw(cmd);
                 }
@@ -2,6 +2,7 @@
 #pragma once
 #include "device.hpp"
 #include "pipeline.hpp"
+#include "pipeline_library.hpp"
 #include "buffers.hpp"
 #include "ecs_registry.hpp"
 #include "texture2d.hpp"
@@ -12,21 +13,27 @@ namespace lavander
     class Renderer2D
     {
     public:
-        Renderer2D(c_device& device, VkRenderPass renderPass, VkExtent2D extent, VkPipelineLayout layout, VkDescriptorSetLayout materialSetLayout, VkDescriptorPool materialPool);
+        Renderer2D(c_device& device, PipelineLibrary& pipelines, VkRenderPass renderPass, VkPipelineLayout layout, VkDescriptorSetLayout materialSetLayout, DescriptorAllocator& materialDescriptors);
+        //variant the renderer falls back to while specialised ones compile, built at startup
+        static constexpr uint32_t kBaseFeatures = SHADER_FEATURE_TEXTURE;
+
+        //the pipeline this renderer draws with, so it can be compiled ahead of time
+        static PipelineDesc describePipeline(VkRenderPass renderPass, VkPipelineLayout layout, uint32_t features = kBaseFeatures);
         void draw(VkCommandBuffer cmd, ECSRegistry& registry);
 
     private:
         c_device& deviceRef;
         VkPipelineLayout        pipelineLayout;
-        std::unique_ptr<c_pipeline> pipeline;
+        PipelineLibrary&        pipelines;
+        std::unique_ptr<PipelineVariantSet> variants;
         std::unique_ptr<c_buffers> quadBuffers;
 
         VkDescriptorSetLayout materialSetLayout{};
-        VkDescriptorPool materialPool{};
+        DescriptorAllocator&  materialDescriptors;
         std::shared_ptr<Texture2D>  defaultWhite;
         VkDescriptorSet             defaultWhiteSet{};
 
-        void createPipeline(VkRenderPass renderPass, VkExtent2D extent);
+        void createPipeline(VkRenderPass renderPass);
         void createQuadBuffers();
         void createDefaultTexture();
     };
@@ -3,22 +3,30 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "components.hpp"
+#include "cpu_profiler.hpp"
+#include "render_stats.hpp"
 
 namespace lavander
 {
-    Renderer3D::Renderer3D(c_device& device, VkRenderPass renderPass, VkExtent2D extent, VkPipelineLayout layout, VkDescriptorSetLayout matLayout, VkDescriptorPool matPool)
-        : deviceRef(device), pipelineLayout(layout), materialSetLayout(matLayout), materialPool(matPool)
+    Renderer3D::Renderer3D(c_device& device, PipelineLibrary& pipelines, VkRenderPass renderPass, VkPipelineLayout layout, VkDescriptorSetLayout matLayout, DescriptorAllocator& matDescriptors)
+        : deviceRef(device), pipelines(pipelines), pipelineLayout(layout), materialSetLayout(matLayout), materialDescriptors(matDescriptors)
     {
         defaultWhite = std::make_shared<Texture2D>(deviceRef, 255, 255, 255, 255);
-        defaultWhite->allocateDescriptor(materialPool, materialSetLayout);
-        createPipeline(renderPass, extent);
+        defaultWhite->allocateDescriptor(materialDescriptors, materialSetLayout);
+        createPipeline(renderPass);
     }
 
-    void Renderer3D::createPipeline(VkRenderPass rp, VkExtent2D extent)
+    PipelineDesc Renderer3D::describePipeline(VkRenderPass rp, VkPipelineLayout layout, uint32_t features)
     {
-        auto cfg = c_pipeline::defaultPipelineConfigInfo(extent.width, extent.height);
+        PipelineDesc desc;
+        desc.vertPath = "../../src/shaders/mesh.vert.spv";
+        desc.fragPath = "../../src/shaders/mesh.frag.spv";
+
+        auto& cfg = desc.config;
+        cfg = c_pipeline::defaultPipelineConfigInfo();
         cfg.renderPass = rp;
-        cfg.pipelineLayout = pipelineLayout;
+        cfg.pipelineLayout = layout;
+        cfg.features = features;
 
         //backface culling
         cfg.rasterizationInfo.cullMode = VK_CULL_MODE_BACK_BIT;
@@ -32,17 +40,21 @@ namespace lavander
         cfg.bindingDescriptions = { bind };
         cfg.attributeDescriptions = { attrs.begin(), attrs.end() };
 
-        pipeline = std::make_unique<c_pipeline>(
-            deviceRef,
-            "../../src/shaders/mesh.vert.spv",
-            "../../src/shaders/mesh.frag.spv",
-            cfg
-        );
+        return desc;
+    }
+
+    void Renderer3D::createPipeline(VkRenderPass rp)
+    {
+        VkPipelineLayout layout = pipelineLayout;
+        variants = std::make_unique<PipelineVariantSet>(pipelines, kBaseFeatures,
+            [rp, layout](uint32_t features) { return describePipeline(rp, layout, features); });
     }
 
     void Renderer3D::draw(VkCommandBuffer cmd, ECSRegistry& registry)
     {
-        pipeline->bind(cmd);
+        PROFILE_SCOPE("Renderer3D::draw");
+        variants->poll();
+        c_pipeline* bound = nullptr;
 
         auto& meshrByEntity = registry.getAllComponentsOfType<MeshRenderer3D>();
         for (auto& [entity, renderers] : meshrByEntity)
@@ -59,12 +71,22 @@ namespace lavander
                 {
                     if (r.texture->descriptorSet() == VK_NULL_HANDLE) 
                     {
-                        r.texture->allocateDescriptor(materialPool, materialSetLayout);
+                        r.texture->allocateDescriptor(materialDescriptors, materialSetLayout);
                     }
                     matSet = r.texture->descriptorSet();
                 }
 
+                //untextured meshes skip the fetch, unlit ones the lighting
+                uint32_t features = (r.texture ? SHADER_FEATURE_TEXTURE : 0u) | (r.lit ? SHADER_FEATURE_LIT : 0u);
+                c_pipeline& p = variants->get(features);
+                if (&p != bound)
+                {
+                    p.bind(cmd);
+                    bound = &p;
+                }
+
                 vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &matSet, 0, nullptr);
+                RenderStats::Get().countDescriptorBind();
 
                 for (auto& t : *transfs)
                 {
@@ -80,6 +102,7 @@ namespace lavander
                     pc.color = glm::vec4(r.color, 1.0f);
 
                     vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConst), &pc);
+                    RenderStats::Get().countPushConstants();
 
                     for (auto& f : *filters)
                     {
@@ -1,27 +1,36 @@
 #pragma once
 #include "pipeline.hpp"
+#include "pipeline_library.hpp"
 #include "device.hpp"
 #include "texture2d.hpp"
 #include "ecs_registry.hpp"
 #include "mesh.hpp"
 
+#include <memory>
+
 namespace lavander
 {
     class Renderer3D 
     {
     public:
-        Renderer3D(c_device& device, VkRenderPass renderPass, VkExtent2D extent, VkPipelineLayout pipelineLayout, VkDescriptorSetLayout materialSetLayout, VkDescriptorPool materialPool);
-        
+        Renderer3D(c_device& device, PipelineLibrary& pipelines, VkRenderPass renderPass, VkPipelineLayout pipelineLayout, VkDescriptorSetLayout materialSetLayout, DescriptorAllocator& materialDescriptors);
+        //variant the renderer falls back to while specialised ones compile, built at startup
+        static constexpr uint32_t kBaseFeatures = SHADER_FEATURE_TEXTURE | SHADER_FEATURE_LIT;
+
+        //the pipeline this renderer draws with, so it can be compiled ahead of time
+        static PipelineDesc describePipeline(VkRenderPass renderPass, VkPipelineLayout layout, uint32_t features = kBaseFeatures);
+
         void draw(VkCommandBuffer cmd, ECSRegistry& registry);
 
     private:
-        void createPipeline(VkRenderPass rp, VkExtent2D extent);
+        void createPipeline(VkRenderPass rp);
 
         c_device& deviceRef;
-        std::unique_ptr<c_pipeline> pipeline;
+        PipelineLibrary& pipelines;
+        std::unique_ptr<PipelineVariantSet> variants;
         VkPipelineLayout pipelineLayout;
         VkDescriptorSetLayout materialSetLayout;
-        VkDescriptorPool materialPool;
+        DescriptorAllocator& materialDescriptors;
         std::shared_ptr<Texture2D> defaultWhite;
     };
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include "runtime.hpp"
+#include "cpu_profiler.hpp"
+
+#include <chrono>
+
+namespace lavander
+{
+    void Runtime::addSystem(std::string name, System update)
+    {
+        systems_.push_back({ std::move(name), std::move(update) });
+    }
+
+    void Runtime::tick(float dt)
+    {
+        PROFILE_SCOPE("Runtime::tick");
+        using clock = std::chrono::steady_clock;
+        auto tickBegin = clock::now();
+
+        for (SystemInfo& system : systems_)
+        {
+            auto begin = clock::now();
+            system.update(registry_, dt);
+            system.lastMs = std::chrono::duration<float, std::milli>(clock::now() - begin).count();
+        }
+
+        tickCount_++;
+        time_ += dt;
+        lastTickMs_ = std::chrono::duration<float, std::milli>(clock::now() - tickBegin).count();
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "ecs_registry.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace lavander
+{
+    // The simulation half of the engine: registry, systems and time. Needs no window or
+    // device, so it runs on its own for headless batch simulation and CPU benchmarks;
+    // Engine owns one and ticks it once per rendered frame.
+    class Runtime
+    {
+    public:
+        using System = std::function<void(ECSRegistry& registry, float dt)>;
+
+        struct SystemInfo
+        {
+            std::string name;
+            System      update;
+            float       lastMs = 0.0f; // CPU time of the most recent tick
+        };
+
+        Runtime() = default;
+
+        Runtime(const Runtime&) = delete;
+        Runtime& operator=(const Runtime&) = delete;
+
+        //systems run in the order they were added
+        void addSystem(std::string name, System update);
+
+        //advances time by dt and runs every system once
+        void tick(float dt);
+
+        ECSRegistry& registry() { return registry_; }
+        const std::vector<SystemInfo>& systems() const { return systems_; }
+
+        uint64_t tickCount() const { return tickCount_; }
+        double   time() const { return time_; }       // simulated seconds
+        float    lastTickMs() const { return lastTickMs_; }
+
+    private:
+        ECSRegistry registry_;
+        std::vector<SystemInfo> systems_;
+
+        uint64_t tickCount_ = 0;
+        double   time_ = 0.0;
+        float    lastTickMs_ = 0.0f;
+    };
+}
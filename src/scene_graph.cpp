@@ -1,5 +1,6 @@
 #include "scene_graph.hpp"
 #include "component_type_db.hpp"
+#include "cpu_profiler.hpp"
 #include <algorithm>
 #include <cstring> 
 #include <imgui.h>
@@ -59,7 +60,7 @@ namespace lavander
             }
 
             //possible extensions for sprite files
-            static const char* exts[] = { ".png", ".jpg", ".jpeg", ".bmp", ".tga", ".gif", ".hdr", ".dds" };
+            static const char* exts[] = { ".png", ".jpg", ".jpeg", ".bmp", ".tga", ".gif", ".hdr", ".dds", ".ktx2" };
 
             ImGui::BeginChild("##assets_list", ImVec2(0, 300), true);
 
@@ -112,6 +113,8 @@ namespace lavander
 
     void SceneGraph::OnImGuiRender()
     {
+        PROFILE_SCOPE("SceneGraph::OnImGuiRender");
+
         //scene hierarchy
         ImGui::Begin("Hierarchy###SceneHierarchy");
 
@@ -306,6 +309,7 @@ namespace lavander
                     SpriteRenderer& sr = (*srs)[si];
 
                     ImGui::ColorEdit3("Color", &sr.color.x);
+                    ImGui::Checkbox("Alpha Test", &sr.alphaTest);
 
                     //texture ui
                     const char* texLabel = (sr.texture ? "Texture: (set)" : "Texture: <None>");
@@ -1,55 +1,57 @@
 #include "scene_render_target.hpp"
 #include <stdexcept>
+#include <algorithm>
 #include <array>
 #include <imgui_impl_vulkan.h>
 
 namespace lavander {
 
-    static uint32_t findMemoryType(VkPhysicalDevice phys, uint32_t typeBits, VkMemoryPropertyFlags props) 
+    void SceneRenderTarget::create(c_device& device, VkExtent2D ext, VkFormat colorFormat, VkRenderPass* outRP, VkRenderPass sharedRP)
     {
-        VkPhysicalDeviceMemoryProperties m{};
-        vkGetPhysicalDeviceMemoryProperties(phys, &m);
-        for (uint32_t i = 0; i < m.memoryTypeCount; i++) 
-        {
-            if ((typeBits & (1u << i)) && (m.memoryTypes[i].propertyFlags & props) == props)
-            {
-                return i;
-            }
-        }
-        throw std::runtime_error("No suitable memory type");
-    }
+        owner_ = &device;
+        device_ = device.device(); phys_ = device.getPhysicalDevice();
+        extent_ = ext; renderExtent_ = ext; colorFormat_ = colorFormat;
 
-    void SceneRenderTarget::create(VkDevice device, VkPhysicalDevice phys, VkExtent2D ext, VkFormat colorFormat, VkRenderPass* outRP)
-    {
-        device_ = device; phys_ = phys; extent_ = ext;
-
-        createRenderPass(colorFormat);
+        ownsRenderPass_ = (sharedRP == VK_NULL_HANDLE);
+        if (ownsRenderPass_) createRenderPass(colorFormat);
+        else renderPass_ = sharedRP;
         createImage(colorFormat);
-        createViewAndSampler(colorFormat);
+        createView(colorFormat);
+        createSampler();
 
         depthFormat_ = pickDepthFormat();
         createDepthImageAndView();
 
         createFramebuffer();
 
-        imguiTexId_ = (ImTextureID)ImGui_ImplVulkan_AddTexture(sampler_, imageView_, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
         if (outRP) *outRP = renderPass_;
     }
 
+    ImTextureID SceneRenderTarget::imguiTexId()
+    {
+        if (!imguiTexId_ && imageView_)
+        {
+            imguiTexId_ = (ImTextureID)ImGui_ImplVulkan_AddTexture(sampler_, imageView_, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+        return imguiTexId_;
+    }
+
     void SceneRenderTarget::cleanup() 
     {
         if (!device_) return;
 
-        if (framebuffer_) vkDestroyFramebuffer(device_, framebuffer_, nullptr);
-        if (renderPass_)  vkDestroyRenderPass(device_, renderPass_, nullptr);
-        if (sampler_)     vkDestroySampler(device_, sampler_, nullptr);
-        if (imageView_)   vkDestroyImageView(device_, imageView_, nullptr);
-        if (image_)       vkDestroyImage(device_, image_, nullptr);
-        if (imageMem_)    vkFreeMemory(device_, imageMem_, nullptr);
-        if (depthView_)   vkDestroyImageView(device_, depthView_, nullptr);
-        if (depthImage_)  vkDestroyImage(device_, depthImage_, nullptr);
-        if (depthMem_)    vkFreeMemory(device_, depthMem_, nullptr);
+        if (imguiTexId_) ImGui_ImplVulkan_RemoveTexture((VkDescriptorSet)imguiTexId_);
+        imguiTexId_ = 0;
+
+        if (framebuffer_) vkDestroyFramebuffer(device_, framebuffer_, c_device::allocator());
+        if (renderPass_ && ownsRenderPass_) vkDestroyRenderPass(device_, renderPass_, c_device::allocator());
+        if (sampler_)     vkDestroySampler(device_, sampler_, c_device::allocator());
+        if (imageView_)   vkDestroyImageView(device_, imageView_, c_device::allocator());
+        if (image_)       vkDestroyImage(device_, image_, c_device::allocator());
+        if (imageMem_)    owner_->freeMemory(imageMem_);
+        if (depthView_)   vkDestroyImageView(device_, depthView_, c_device::allocator());
+        if (depthImage_)  vkDestroyImage(device_, depthImage_, c_device::allocator());
+        if (depthMem_)    owner_->freeMemory(depthMem_);
 
         framebuffer_ = VK_NULL_HANDLE;
         renderPass_ = VK_NULL_HANDLE;
@@ -63,10 +65,59 @@ namespace lavander {
         device_ = VK_NULL_HANDLE;
     }
 
-    void SceneRenderTarget::resize(VkDevice device, VkPhysicalDevice phys, VkExtent2D newExt, VkFormat fmt)
+    bool SceneRenderTarget::fit(VkExtent2D display, float renderScale)
     {
-        cleanup();
-        create(device, phys, newExt, fmt, nullptr);
+        VkExtent2D want{
+            std::max(1u, uint32_t(float(display.width) * renderScale + 0.5f)),
+            std::max(1u, uint32_t(float(display.height) * renderScale + 0.5f)) };
+
+        const bool grow = want.width > extent_.width || want.height > extent_.height;
+        const bool shrink = uint64_t(want.width) * want.height * 4 < uint64_t(extent_.width) * extent_.height;
+
+        bool reallocated = false;
+        if (grow || shrink)
+        {
+            //round up so dragging a panel edge doesn't reallocate every few pixels
+            auto roundUp = [](uint32_t v) { return (v + 63u) & ~63u; };
+            VkExtent2D capacity{ roundUp(want.width), roundUp(want.height) };
+            if (!shrink)
+            {
+                capacity.width = std::max(capacity.width, extent_.width);
+                capacity.height = std::max(capacity.height, extent_.height);
+            }
+            reallocate(capacity);
+            reallocated = true;
+        }
+
+        renderExtent_ = want;
+        return reallocated;
+    }
+
+    void SceneRenderTarget::reallocate(VkExtent2D capacity)
+    {
+        //frames in flight still render into or sample the old images
+        VkDevice dev = device_;
+        VkDescriptorSet oldTex = (VkDescriptorSet)imguiTexId_;
+        c_device* owner = owner_;
+        owner_->deferDestroy([dev, owner, oldTex, fb = framebuffer_, view = imageView_, image = image_, mem = imageMem_,
+            dView = depthView_, dImage = depthImage_, dMem = depthMem_]()
+        {
+            if (oldTex) ImGui_ImplVulkan_RemoveTexture(oldTex);
+            vkDestroyFramebuffer(dev, fb, c_device::allocator());
+            vkDestroyImageView(dev, view, c_device::allocator());
+            vkDestroyImage(dev, image, c_device::allocator());
+            owner->freeMemory(mem);
+            vkDestroyImageView(dev, dView, c_device::allocator());
+            vkDestroyImage(dev, dImage, c_device::allocator());
+            owner->freeMemory(dMem);
+        });
+
+        extent_ = capacity;
+        createImage(colorFormat_);
+        createView(colorFormat_);
+        createDepthImageAndView();
+        createFramebuffer();
+        imguiTexId_ = 0;
     }
 
     void SceneRenderTarget::createImage(VkFormat format)
@@ -79,30 +130,16 @@ namespace lavander {
         ci.format = format;
         ci.tiling = VK_IMAGE_TILING_OPTIMAL;
         ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        ci.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        //transfer src for offscreen readback
+        ci.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
         ci.samples = VK_SAMPLE_COUNT_1_BIT;
         ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        if (vkCreateImage(device_, &ci, nullptr, &image_) != VK_SUCCESS)
-        {
-            throw std::runtime_error("SceneRT color image");
-        }
-
-        VkMemoryRequirements req{};
-        vkGetImageMemoryRequirements(device_, image_, &req);
-        VkMemoryAllocateInfo ai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-        ai.allocationSize = req.size;
-        ai.memoryTypeIndex = findMemoryType(phys_, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-        if (vkAllocateMemory(device_, &ai, nullptr, &imageMem_) != VK_SUCCESS)
-        {
-            throw std::runtime_error("SceneRT color image mem");
-        }
-
-        vkBindImageMemory(device_, image_, imageMem_, 0);
+        owner_->createImageWithInfo(ci, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image_, imageMem_,
+            MemoryCategory::RenderTarget, "scene color");
     }
 
-    void SceneRenderTarget::createViewAndSampler(VkFormat format)
+    void SceneRenderTarget::createView(VkFormat format)
     {
         VkImageViewCreateInfo vi{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
         vi.image = image_;
@@ -112,11 +149,15 @@ namespace lavander {
         vi.subresourceRange.levelCount = 1;
         vi.subresourceRange.layerCount = 1;
 
-        if (vkCreateImageView(device_, &vi, nullptr, &imageView_) != VK_SUCCESS)
+        if (vkCreateImageView(device_, &vi, c_device::allocator(), &imageView_) != VK_SUCCESS)
         {
             throw std::runtime_error("SceneRT color view");
         }
+    }
 
+    void SceneRenderTarget::createSampler()
+    {
+        //linear, the composite upscales the rendered region to the panel
         VkSamplerCreateInfo si{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
         si.magFilter = VK_FILTER_LINEAR;
         si.minFilter = VK_FILTER_LINEAR;
@@ -124,7 +165,7 @@ namespace lavander {
         si.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
         si.minLod = 0; si.maxLod = 0;
 
-        if (vkCreateSampler(device_, &si, nullptr, &sampler_) != VK_SUCCESS)
+        if (vkCreateSampler(device_, &si, c_device::allocator(), &sampler_) != VK_SUCCESS)
         {
             throw std::runtime_error("SceneRT sampler");
         }
@@ -166,23 +207,8 @@ namespace lavander {
         ci.samples = VK_SAMPLE_COUNT_1_BIT;
         ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        if (vkCreateImage(device_, &ci, nullptr, &depthImage_) != VK_SUCCESS)
-        {
-            throw std::runtime_error("SceneRT depth image");
-        }
-
-        VkMemoryRequirements req{};
-        vkGetImageMemoryRequirements(device_, depthImage_, &req);
-        VkMemoryAllocateInfo ai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-        ai.allocationSize = req.size;
-        ai.memoryTypeIndex = findMemoryType(phys_, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-        if (vkAllocateMemory(device_, &ai, nullptr, &depthMem_) != VK_SUCCESS) 
-        {
-            throw std::runtime_error("SceneRT depth image mem");
-        }
-
-        vkBindImageMemory(device_, depthImage_, depthMem_, 0);
+        owner_->createImageWithInfo(ci, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage_, depthMem_,
+            MemoryCategory::RenderTarget, "scene depth");
 
         VkImageViewCreateInfo vi{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
         vi.image = depthImage_;
@@ -197,7 +223,7 @@ namespace lavander {
             vi.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
         }
 
-        if (vkCreateImageView(device_, &vi, nullptr, &depthView_) != VK_SUCCESS)
+        if (vkCreateImageView(device_, &vi, c_device::allocator(), &depthView_) != VK_SUCCESS)
         {
             throw std::runtime_error("SceneRT depth view");
         }
@@ -242,7 +268,9 @@ namespace lavander {
         VkSubpassDependency depIn{};
         depIn.srcSubpass = VK_SUBPASS_EXTERNAL;
         depIn.dstSubpass = 0;
-        depIn.srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        //each frame in flight has its own target, so only order against earlier attachment
+        //output instead of waiting for all prior work (the old composite read)
+        depIn.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
         depIn.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
         depIn.srcAccessMask = 0;
         depIn.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
@@ -268,7 +296,7 @@ namespace lavander {
         rp.dependencyCount = static_cast<uint32_t>(deps.size());
         rp.pDependencies = deps.data();
 
-        if (vkCreateRenderPass(device_, &rp, nullptr, &renderPass_) != VK_SUCCESS)
+        if (vkCreateRenderPass(device_, &rp, c_device::allocator(), &renderPass_) != VK_SUCCESS)
         {
             throw std::runtime_error("SceneRT render pass");
         }
@@ -289,7 +317,7 @@ namespace lavander {
         fi.height = extent_.height;
         fi.layers = 1;
 
-        if (vkCreateFramebuffer(device_, &fi, nullptr, &framebuffer_) != VK_SUCCESS)
+        if (vkCreateFramebuffer(device_, &fi, c_device::allocator(), &framebuffer_) != VK_SUCCESS)
         {
             throw std::runtime_error("SceneRT framebuffer");
         }
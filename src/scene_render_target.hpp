@@ -1,36 +1,59 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include <imgui.h>
+#include "device.hpp"
 
 namespace lavander
 {
 
+    // Offscreen color + depth target the scene renders into before ImGui composites it.
+    // The images are allocated at capacity() and the scene only renders the extent() corner,
+    // so panel resizes and render scale changes mostly don't reallocate anything.
     class SceneRenderTarget
     {
     public:
         SceneRenderTarget() = default;
         ~SceneRenderTarget() { cleanup(); }
 
-        void create(VkDevice device, VkPhysicalDevice phys, VkExtent2D extent, VkFormat colorFormat, VkRenderPass* outRenderPass);
+        //sharedRenderPass lets several targets use one pass (and so one set of pipelines),
+        //the target that created it owns it and must be cleaned up last
+        void create(c_device& device, VkExtent2D extent, VkFormat colorFormat, VkRenderPass* outRenderPass,
+            VkRenderPass sharedRenderPass = VK_NULL_HANDLE);
+        //destroys immediately, the device must be idle and ImGui still alive
         void cleanup();
 
         VkRenderPass   renderPass()  const { return renderPass_; }
         VkFramebuffer  framebuffer() const { return framebuffer_; }
-        VkExtent2D     extent()      const { return extent_; }
-        ImTextureID    imguiTexId()  const { return imguiTexId_; }
+        //region the scene renders into, at most capacity()
+        VkExtent2D     extent()      const { return renderExtent_; }
+        VkExtent2D     capacity()    const { return extent_; }
+        //registered with ImGui on first use, so offscreen targets never touch ImGui
+        ImTextureID    imguiTexId();
+        VkImage        image()       const { return image_; }
+        VkFormat       colorFormat() const { return colorFormat_; }
+        //bottom right uv of the rendered region
+        ImVec2         uvMax()       const { return ImVec2(float(renderExtent_.width) / float(extent_.width), float(renderExtent_.height) / float(extent_.height)); }
 
-        void resize(VkDevice device, VkPhysicalDevice phys, VkExtent2D newExtent, VkFormat colorFormat);
+        // Renders displayExtent * renderScale from now on. Reallocates (keeping the render pass,
+        // so pipelines stay valid) only when that doesn't fit or would use under a quarter of the
+        // images; the old images are released through the device's deletion queue.
+        // Returns true when it reallocated.
+        bool fit(VkExtent2D displayExtent, float renderScale);
 
         VkImageView    imageView_ = VK_NULL_HANDLE;
         VkSampler      sampler_ = VK_NULL_HANDLE;
 
     private:
+        c_device*      owner_ = nullptr;
         VkDevice       device_ = VK_NULL_HANDLE;
         VkPhysicalDevice phys_ = VK_NULL_HANDLE;
         VkExtent2D     extent_{};
+        VkExtent2D     renderExtent_{};
+        VkFormat       colorFormat_ = VK_FORMAT_UNDEFINED;
         VkImage        image_ = VK_NULL_HANDLE;
         VkDeviceMemory imageMem_ = VK_NULL_HANDLE;
         VkRenderPass   renderPass_ = VK_NULL_HANDLE;
+        bool           ownsRenderPass_ = false;
         VkFramebuffer  framebuffer_ = VK_NULL_HANDLE;
         ImTextureID    imguiTexId_ = 0;
 
@@ -40,9 +63,11 @@ namespace lavander
         VkFormat depthFormat_ = VK_FORMAT_UNDEFINED;
 
         void createImage(VkFormat format);
-        void createViewAndSampler(VkFormat format);
+        void createView(VkFormat format);
+        void createSampler();
         void createRenderPass(VkFormat format);
         void createFramebuffer();
+        void reallocate(VkExtent2D capacity);
 
         VkFormat pickDepthFormat() const;
         void createDepthImageAndView();
@@ -1,6 +1,7 @@
 #include "scene_view_panel.hpp"
 #include <imgui.h>
 #include <ImGuizmo.h>
+#include "render_stats.hpp"
 #include <algorithm>
 
 using namespace lavander;
@@ -18,11 +19,14 @@ void SceneViewPanel::OnImGuiRender()
 
     hovered = ImGui::IsWindowHovered(ImGuiHoveredFlags_ChildWindows);
 
+    ImVec2 fbScale = ImGui::GetIO().DisplayFramebufferScale;
+    viewportPixels = { contentSize.x * fbScale.x, contentSize.y * fbScale.y };
+
     //toolbar for gizmo so transform, rotate and scale plus snap
     {
         ImVec2 toolbarPos = ImVec2(contentPos.x + 8, contentPos.y + 8);
         ImGui::SetCursorScreenPos(toolbarPos);
-        ImGui::BeginChild("##GizmoToolbar", ImVec2(320, 28), false, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
+        ImGui::BeginChild("##GizmoToolbar", ImVec2(400, 28), false, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
 
         bool tSel = (gizmoOp == GizmoOp::Translate);
         bool rSel = (gizmoOp == GizmoOp::Rotate);
@@ -48,6 +52,8 @@ void SceneViewPanel::OnImGuiRender()
 
         ImGui::Checkbox("Snap", &useSnap);
         ImGui::SameLine();
+        ImGui::Checkbox("Stats", &showStats);
+        ImGui::SameLine();
 
         if (useSnap)
         {
@@ -91,6 +97,8 @@ void SceneViewPanel::OnImGuiRender()
 
     if (sceneTex != 0)
     {
+        uv0 = { uv0.x * sceneUvMax.x, uv0.y * sceneUvMax.y };
+        uv1 = { uv1.x * sceneUvMax.x, uv1.y * sceneUvMax.y };
         ImGui::SetCursorScreenPos(contentPos);
         ImGui::Image(sceneTex, contentSize, uv0, uv1);
     }
@@ -191,6 +199,12 @@ void SceneViewPanel::OnImGuiRender()
         }
     }
 
+    //render stats, top right so the view cube keeps its corner
+    if (showStats)
+    {
+        RenderStats::Get().drawOverlay(contentPos.x + contentSize.x - 8.0f, contentPos.y + 8.0f);
+    }
+
     ImGui::End();
     ImGui::PopStyleVar();
 }
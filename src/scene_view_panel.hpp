@@ -23,6 +23,10 @@ namespace lavander
         Camera& camera() { return cam; }
 
         void setSceneAspect(float a) { sceneAspect = a; }
+        //the scene texture is only rendered up to this uv, the rest is spare capacity
+        void setSceneUvMax(ImVec2 uv) { sceneUvMax = uv; }
+        //content size in framebuffer pixels as of the last frame
+        ImVec2 viewportPixelSize() const { return viewportPixels; }
         void setSceneTexture(ImTextureID id) { sceneTex = id; }
         void SetContext(ECSRegistry* reg, Entity selected);
 
@@ -35,11 +39,14 @@ namespace lavander
         Camera cam;
         float aspect = 16.f / 9.f;
         float sceneAspect = 16.0f / 9.0f;
+        ImVec2 sceneUvMax { 1.0f, 1.0f };
+        ImVec2 viewportPixels { 0.0f, 0.0f };
         bool hovered = false;   
         float gridSize = 100.0f;
 
         enum class GizmoOp { Translate, Rotate, Scale } gizmoOp = GizmoOp::Translate;
         bool useSnap = false;
+        bool showStats = true;
         glm::vec3 snapMove { 1.0f,1.0f,1.0f };
         glm::vec3 snapScale { 0.1f,0.1f,0.1f };
         float snapRotateDeg = 90.0f;
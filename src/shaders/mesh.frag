@@ -13,13 +13,31 @@ layout(push_constant) uniform PushConst
     vec4 color;
 } pc;
 
+//variant switches, see ShaderFeature in pipeline.hpp
+layout(constant_id = 0) const bool USE_TEXTURE = true;
+layout(constant_id = 1) const bool LIT = true;
+layout(constant_id = 2) const bool ALPHA_TEST = false;
+
 void main() 
 {
-    vec3 N = normalize(vNormal);
-    vec3 L = normalize(vec3(0.5, 1.0, 0.2));
-    float ndotl = max(dot(N, L), 0.0);
+    vec4 albedo = pc.color;
+    if (USE_TEXTURE)
+    {
+        albedo *= texture(uTex, vUV);
+    }
+
+    if (ALPHA_TEST && albedo.a < 0.5)
+    {
+        discard;
+    }
 
-    vec3 albedo = texture(uTex, vUV).rgb * pc.color.rgb;
-    vec3 lit = albedo * (0.15 + 0.85 * ndotl);
-    outColor = vec4(lit, 1.0);
+    vec3 rgb = albedo.rgb;
+    if (LIT)
+    {
+        vec3 N = normalize(vNormal);
+        vec3 L = normalize(vec3(0.5, 1.0, 0.2));
+        float ndotl = max(dot(N, L), 0.0);
+        rgb *= (0.15 + 0.85 * ndotl);
+    }
+    outColor = vec4(rgb, 1.0);
 }
@@ -6,7 +6,17 @@ layout(set=1, binding=0) uniform sampler2D uTex;
 
 layout(location=0) out vec4 outColor;
 
+//variant switches, see ShaderFeature in pipeline.hpp
+layout(constant_id = 0) const bool USE_TEXTURE = true;
+layout(constant_id = 2) const bool ALPHA_TEST = false;
+
 void main() {
-  vec4 tex = texture(uTex, vUV);
-  outColor = tex * vColor;
+  vec4 color = vColor;
+  if (USE_TEXTURE) {
+    color *= texture(uTex, vUV);
+  }
+  if (ALPHA_TEST && color.a < 0.5) {
+    discard;
+  }
+  outColor = color;
 }
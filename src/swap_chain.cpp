@@ -11,101 +11,135 @@
 
 namespace lavander {
 
-c_swapchain::c_swapchain(c_device &deviceRef, VkExtent2D extent)
-    : device{deviceRef}, windowExtent{extent} {
+c_swapchain::c_swapchain(c_device &deviceRef, VkExtent2D extent, uint32_t framesInFlight)
+    : device{deviceRef}, windowExtent{extent}, framesInFlight{framesInFlight} {
   createSwapChain();
   createImageViews();
+  createSemaphores();
   createRenderPass();
   createDepthResources();
   createFramebuffers();
-  createSyncObjects();
 }
 
 c_swapchain::~c_swapchain() {
+  // device idle doesn't include presents, retired chains may still have some queued
+  vkQueueWaitIdle(device.presentQueue());
+  for (RetiredChain &chain : retired) {
+    chain.destroy();
+  }
+  retired.clear();
+
   for (auto imageView : swapChainImageViews) {
-    vkDestroyImageView(device.device(), imageView, nullptr);
+    vkDestroyImageView(device.device(), imageView, c_device::allocator());
   }
   swapChainImageViews.clear();
 
+  for (VkSemaphore semaphore : renderFinished_) {
+    vkDestroySemaphore(device.device(), semaphore, c_device::allocator());
+  }
+
   if (swapChain != nullptr) {
-    vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
+    vkDestroySwapchainKHR(device.device(), swapChain, c_device::allocator());
     swapChain = nullptr;
   }
 
   for (int i = 0; i < depthImages.size(); i++) {
-    vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-    vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    vkDestroyImageView(device.device(), depthImageViews[i], c_device::allocator());
+    vkDestroyImage(device.device(), depthImages[i], c_device::allocator());
+    device.freeMemory(depthImageMemorys[i]);
   }
 
   for (auto framebuffer : swapChainFramebuffers) {
-    vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
-  }
-
-  vkDestroyRenderPass(device.device(), renderPass, nullptr);
-
-  // cleanup synchronization objects
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
-    vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-    vkDestroyFence(device.device(), inFlightFences[i], nullptr);
+    vkDestroyFramebuffer(device.device(), framebuffer, c_device::allocator());
   }
-}
 
-VkResult c_swapchain::acquireNextImage(uint32_t *imageIndex)
-{
-  vkWaitForFences( device.device(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
-
-  VkResult result = vkAcquireNextImageKHR(device.device(), swapChain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, imageIndex);
-  
-  return result;
+  vkDestroyRenderPass(device.device(), renderPass, c_device::allocator());
 }
 
-VkResult c_swapchain::submitCommandBuffers(
-    const VkCommandBuffer *buffers, uint32_t *imageIndex) {
-  if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-    vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-  }
-  imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
+void c_swapchain::recreate(VkExtent2D extent) {
+  windowExtent = extent;
+
+  VkSwapchainKHR oldSwapChain = swapChain;
+  VkFormat oldFormat = swapChainImageFormat;
+  std::vector<VkImageView> oldImageViews = std::move(swapChainImageViews);
+  std::vector<VkFramebuffer> oldFramebuffers = std::move(swapChainFramebuffers);
+  std::vector<VkImageView> oldDepthViews = std::move(depthImageViews);
+  std::vector<VkImage> oldDepthImages = std::move(depthImages);
+  std::vector<VkDeviceMemory> oldDepthMemory = std::move(depthImageMemorys);
+  std::vector<VkSemaphore> oldRenderFinished = std::move(renderFinished_);
+  swapChainImageViews.clear();
+  swapChainFramebuffers.clear();
+  depthImageViews.clear();
+  depthImages.clear();
+  depthImageMemorys.clear();
+  renderFinished_.clear();
 
-  VkSubmitInfo submitInfo = {};
-  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  createSwapChain();
 
-  VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-  VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submitInfo.waitSemaphoreCount = 1;
-  submitInfo.pWaitSemaphores = waitSemaphores;
-  submitInfo.pWaitDstStageMask = waitStages;
+  // frames in flight may still render to or present the old images, present() hands this to
+  // the deletion queue once the new chain has presented past them
+  VkDevice dev = device.device();
+  c_device *owner = &device;
+  retired.push_back({[=]() {
+    for (auto framebuffer : oldFramebuffers) vkDestroyFramebuffer(dev, framebuffer, c_device::allocator());
+    for (auto imageView : oldImageViews) vkDestroyImageView(dev, imageView, c_device::allocator());
+    for (size_t i = 0; i < oldDepthImages.size(); i++) {
+      vkDestroyImageView(dev, oldDepthViews[i], c_device::allocator());
+      vkDestroyImage(dev, oldDepthImages[i], c_device::allocator());
+      owner->freeMemory(oldDepthMemory[i]);
+    }
+    for (VkSemaphore semaphore : oldRenderFinished) vkDestroySemaphore(dev, semaphore, c_device::allocator());
+    vkDestroySwapchainKHR(dev, oldSwapChain, c_device::allocator());
+  }, framesInFlight + 1});
 
-  submitInfo.commandBufferCount = 1;
-  submitInfo.pCommandBuffers = buffers;
+  if (swapChainImageFormat != oldFormat) {
+    throw std::runtime_error("swap chain image format has changed!");
+  }
 
-  VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-  submitInfo.signalSemaphoreCount = 1;
-  submitInfo.pSignalSemaphores = signalSemaphores;
+  createImageViews();
+  createSemaphores();
+  createDepthResources();
+  createFramebuffers();
+}
 
-  vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-  if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-      VK_SUCCESS) {
-    throw std::runtime_error("failed to submit draw command buffer!");
-  }
+VkResult c_swapchain::acquireNextImage(VkSemaphore imageAvailable, uint32_t *imageIndex) {
+  // frame pacing lives with the frame contexts, this only hands out the next image
+  return vkAcquireNextImageKHR(
+      device.device(),
+      swapChain,
+      std::numeric_limits<uint64_t>::max(),
+      imageAvailable,
+      VK_NULL_HANDLE,
+      imageIndex);
+}
 
+VkResult c_swapchain::present(uint32_t imageIndex) {
   VkPresentInfoKHR presentInfo = {};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
   presentInfo.waitSemaphoreCount = 1;
-  presentInfo.pWaitSemaphores = signalSemaphores;
+  presentInfo.pWaitSemaphores = &renderFinished_[imageIndex];
 
   VkSwapchainKHR swapChains[] = {swapChain};
   presentInfo.swapchainCount = 1;
   presentInfo.pSwapchains = swapChains;
 
-  presentInfo.pImageIndices = imageIndex;
-
-  auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+  presentInfo.pImageIndices = &imageIndex;
 
-  currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+  VkResult result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
+  // after enough presents on the new chain the old chain's presents are behind frames the
+  // timeline tracks, from there the deletion queue's wait covers them
+  if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+    for (auto it = retired.begin(); it != retired.end();) {
+      if (--it->presentsLeft == 0) {
+        device.deferDestroy(std::move(it->destroy));
+        it = retired.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
   return result;
 }
 
@@ -152,9 +186,10 @@ void c_swapchain::createSwapChain() {
   createInfo.presentMode = presentMode;
   createInfo.clipped = VK_TRUE;
 
-  createInfo.oldSwapchain = VK_NULL_HANDLE;
+  // null on first creation, otherwise lets the driver reuse the retiring chain's resources
+  createInfo.oldSwapchain = swapChain;
 
-  if (vkCreateSwapchainKHR(device.device(), &createInfo, nullptr, &swapChain) != VK_SUCCESS) {
+  if (vkCreateSwapchainKHR(device.device(), &createInfo, c_device::allocator(), &swapChain) != VK_SUCCESS) {
     throw std::runtime_error("failed to create swap chain!");
   }
 
@@ -184,13 +219,26 @@ void c_swapchain::createImageViews() {
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
-    if (vkCreateImageView(device.device(), &viewInfo, nullptr, &swapChainImageViews[i]) !=
+    if (vkCreateImageView(device.device(), &viewInfo, c_device::allocator(), &swapChainImageViews[i]) !=
         VK_SUCCESS) {
       throw std::runtime_error("failed to create texture image view!");
     }
   }
 }
 
+void c_swapchain::createSemaphores() {
+  VkSemaphoreCreateInfo semaphoreInfo{};
+  semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+  renderFinished_.resize(swapChainImages.size());
+  for (size_t i = 0; i < renderFinished_.size(); i++) {
+    if (vkCreateSemaphore(device.device(), &semaphoreInfo, c_device::allocator(), &renderFinished_[i]) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to create present semaphore!");
+    }
+  }
+}
+
 void c_swapchain::createRenderPass() {
   VkAttachmentDescription depthAttachment{};
   depthAttachment.format = findDepthFormat();
@@ -247,7 +295,7 @@ void c_swapchain::createRenderPass() {
   renderPassInfo.dependencyCount = 1;
   renderPassInfo.pDependencies = &dependency;
 
-  if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+  if (vkCreateRenderPass(device.device(), &renderPassInfo, c_device::allocator(), &renderPass) != VK_SUCCESS) {
     throw std::runtime_error("failed to create render pass!");
   }
 }
@@ -270,7 +318,7 @@ void c_swapchain::createFramebuffers() {
     if (vkCreateFramebuffer(
             device.device(),
             &framebufferInfo,
-            nullptr,
+            c_device::allocator(),
             &swapChainFramebuffers[i]) != VK_SUCCESS) {
       throw std::runtime_error("failed to create framebuffer!");
     }
@@ -306,7 +354,9 @@ void c_swapchain::createDepthResources() {
         imageInfo,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         depthImages[i],
-        depthImageMemorys[i]);
+        depthImageMemorys[i],
+        MemoryCategory::RenderTarget,
+        "swapchain depth");
 
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -319,36 +369,12 @@ void c_swapchain::createDepthResources() {
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
-    if (vkCreateImageView(device.device(), &viewInfo, nullptr, &depthImageViews[i]) != VK_SUCCESS) {
+    if (vkCreateImageView(device.device(), &viewInfo, c_device::allocator(), &depthImageViews[i]) != VK_SUCCESS) {
       throw std::runtime_error("failed to create texture image view!");
     }
   }
 }
 
-void c_swapchain::createSyncObjects() {
-  imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-  renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-  inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-  imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
-
-  VkSemaphoreCreateInfo semaphoreInfo = {};
-  semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-  VkFenceCreateInfo fenceInfo = {};
-  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-  fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
-            VK_SUCCESS ||
-        vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
-            VK_SUCCESS ||
-        vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
-      throw std::runtime_error("failed to create synchronization objects for a frame!");
-    }
-  }
-}
-
 VkSurfaceFormatKHR c_swapchain::chooseSwapSurfaceFormat(
     const std::vector<VkSurfaceFormatKHR> &availableFormats) {
   for (const auto &availableFormat : availableFormats) {
@@ -6,6 +6,7 @@
 #include <vulkan/vulkan.h>
 
 // std lib headers
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -13,9 +14,8 @@ namespace lavander {
 
 class c_swapchain {
  public:
-  static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-  c_swapchain(c_device &deviceRef, VkExtent2D windowExtent);
+  // framesInFlight: how far the CPU may run ahead, retired chains outlive that many presents
+  c_swapchain(c_device &deviceRef, VkExtent2D windowExtent, uint32_t framesInFlight = 2);
   ~c_swapchain();
 
   c_swapchain(const c_swapchain &) = delete;
@@ -35,16 +35,28 @@ class c_swapchain {
   }
   VkFormat findDepthFormat();
 
-  VkResult acquireNextImage(uint32_t *imageIndex);
-  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  // Rebuilds the chain for a new window size, handing the current one over as oldSwapchain.
+  // Only size dependent state is recreated (images, views, depth, framebuffers), the render
+  // pass and everything built against it stay valid. The timeline doesn't cover presents, so
+  // the old objects are kept until the new chain presented framesInFlight + 1 frames, then go
+  // through the device's deletion queue. This never waits for the GPU.
+  void recreate(VkExtent2D windowExtent);
+
+  // imageAvailable is signalled once the image can be rendered to. The submit rendering the
+  // image signals renderFinished(imageIndex), which present waits on. It is one semaphore per
+  // image rather than per frame slot, so it is only signalled again after the image came back
+  // from its previous present.
+  VkResult acquireNextImage(VkSemaphore imageAvailable, uint32_t *imageIndex);
+  VkSemaphore renderFinished(uint32_t imageIndex) { return renderFinished_[imageIndex]; }
+  VkResult present(uint32_t imageIndex);
 
  private:
   void createSwapChain();
   void createImageViews();
+  void createSemaphores();
   void createDepthResources();
   void createRenderPass();
   void createFramebuffers();
-  void createSyncObjects();
 
   // Helper functions
   VkSurfaceFormatKHR chooseSwapSurfaceFormat(
@@ -64,17 +76,19 @@ class c_swapchain {
   std::vector<VkImageView> depthImageViews;
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
+  std::vector<VkSemaphore> renderFinished_;
 
   c_device &device;
   VkExtent2D windowExtent;
 
-  VkSwapchainKHR swapChain;
+  VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 
-  std::vector<VkSemaphore> imageAvailableSemaphores;
-  std::vector<VkSemaphore> renderFinishedSemaphores;
-  std::vector<VkFence> inFlightFences;
-  std::vector<VkFence> imagesInFlight;
-  size_t currentFrame = 0;
+  struct RetiredChain {
+    std::function<void()> destroy;
+    uint32_t presentsLeft;
+  };
+  std::vector<RetiredChain> retired;
+  uint32_t framesInFlight;
 };
 
 }  // namespace lavander
@@ -3,13 +3,18 @@
 #include "stb_image.h"
 
 #include "texture2d.hpp"
+#include "ktx2.hpp"
+#include "cpu_profiler.hpp"
+#include "render_stats.hpp"
 #include <stdexcept>
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 namespace lavander 
 {
 
-    static void transition(VkCommandBuffer cmd, VkImage img,VkImageLayout oldL, VkImageLayout newL) 
+    static void transition(VkCommandBuffer cmd, VkImage img, uint32_t mipLevels, VkImageLayout oldL, VkImageLayout newL) 
     {
         VkImageMemoryBarrier b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
         b.oldLayout = oldL;
@@ -19,7 +24,7 @@ namespace lavander
         b.image = img;
         b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         b.subresourceRange.baseMipLevel = 0;
-        b.subresourceRange.levelCount = 1;
+        b.subresourceRange.levelCount = mipLevels;
         b.subresourceRange.baseArrayLayer = 0;
         b.subresourceRange.layerCount = 1;
 
@@ -30,19 +35,29 @@ namespace lavander
         // next transition handled by caller similarly to SHADER_READ_ONLY
     }
 
-    Texture2D::Texture2D(c_device& device, const std::string& path) : device_(device) {
+    Texture2D::Texture2D(c_device& device, const std::string& path, const TextureSettings& settings) : device_(device), name_(path) {
+        PROFILE_SCOPE("Texture2D load");
+        if (Ktx2File::IsKtx2Path(path)) {
+            loadCompressed(path, settings);
+            return;
+        }
+
         int w, h, comp;
         stbi_uc* pixels = stbi_load(path.c_str(), &w, &h, &comp, STBI_rgb_alpha);
         if (!pixels) throw std::runtime_error("failed to load texture: " + path);
 
         width_ = (uint32_t)w;
         height_ = (uint32_t)h;
-        VkFormat fmt = VK_FORMAT_R8G8B8A8_SRGB;
+        VkFormat fmt = settings.srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
 
-        createImage(width_, height_, fmt);
-        upload(pixels, size_t(width_ * height_ * 4), width_, height_);
+        MipChain chain = settings.generateMips
+            ? MipChain::Generate(pixels, width_, height_, settings.srgb)
+            : MipChain::Single(pixels, width_, height_);
         stbi_image_free(pixels);
-        createViewAndSampler(fmt);
+
+        createImage(width_, height_, fmt, uint32_t(chain.levels.size()));
+        upload(chain);
+        createViewAndSampler(fmt, settings);
     }
 
     Texture2D::Texture2D(c_device& device, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
@@ -53,58 +68,236 @@ namespace lavander
             (uint32_t(g) << 8) |
             (uint32_t(b) << 16) |
             (uint32_t(a) << 24);
-        createImage(1, 1, fmt);
-        upload(&px, sizeof(px), 1, 1);
-        createViewAndSampler(fmt);
+        createImage(1, 1, fmt, 1);
+        upload(MipChain::Single(reinterpret_cast<const uint8_t*>(&px), 1, 1));
+        createViewAndSampler(fmt, TextureSettings{});
+    }
+
+    void Texture2D::loadCompressed(const std::string& path, const TextureSettings& settings) {
+        Ktx2File file(path);
+        VkFormat fmt = file.format();
+
+        VkFormatProperties props{};
+        vkGetPhysicalDeviceFormatProperties(device_.getPhysicalDevice(), fmt, &props);
+        if (!(props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+            throw std::runtime_error("texture format not supported by device: " + path);
+
+        width_ = file.width();
+        height_ = file.height();
+
+        // blocks go to the gpu as they are, mips were built by the cooker
+        uint32_t first = 0;
+        uint32_t levels = settings.generateMips ? file.levelCount() : 1;
+
+        if (levels > 1) {
+            // streamed: only the levels up to kInitialResidentExtent are loaded now
+            streamPath_ = path;
+            for (uint32_t i = 0; i < levels; i++) levelBytes_.push_back(file.level(i).size);
+            while (first + 1 < levels && std::max(width_ >> first, height_ >> first) > kInitialResidentExtent) first++;
+            residentMip_ = lowestStreamMip_ = first;
+        }
+
+        MipChain chain = file.readLevels(first, levels - first);
+        createImage(chain.levels[0].width, chain.levels[0].height, fmt, levels - first);
+        upload(chain);
+        createViewAndSampler(fmt, settings);
+    }
+
+    size_t Texture2D::bytesFromMip(uint32_t firstMip) const {
+        size_t total = 0;
+        for (size_t i = firstMip; i < levelBytes_.size(); i++) total += size_t(levelBytes_[i]);
+        return total;
+    }
+
+    static VkImageMemoryBarrier layoutBarrier(VkImage img, uint32_t mipLevels, VkImageLayout oldL, VkImageLayout newL,
+        VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+    {
+        VkImageMemoryBarrier b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        b.oldLayout = oldL;
+        b.newLayout = newL;
+        b.srcAccessMask = srcAccess;
+        b.dstAccessMask = dstAccess;
+        b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.image = img;
+        b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        b.subresourceRange.levelCount = mipLevels;
+        b.subresourceRange.layerCount = 1;
+        return b;
+    }
+
+    std::function<void()> Texture2D::recordStreamTo(VkCommandBuffer cmd, uint32_t firstMip, const MipChain* levels) {
+        if (!streamable() || firstMip == residentMip_ || firstMip >= fullMipLevels())
+            return {};
+
+        //levels read for another resident mip no longer line up with the image
+        const uint32_t fromFile = firstMip < residentMip_ ? residentMip_ - firstMip : 0;
+        if (fromFile && (!levels || levels->levels.size() != fromFile))
+            return {};
+
+        VkImage oldImage = image_;
+        VkDeviceMemory oldMemory = memory_;
+        VkImageView oldView = imageView_;
+        VkDescriptorSet oldSet = descriptorSet_;
+        const uint32_t oldFirst = residentMip_;
+        const uint32_t oldLevels = mipLevels_;
+
+        createImage(std::max(1u, width_ >> firstMip), std::max(1u, height_ >> firstMip), format_, fullMipLevels() - firstMip);
+        sizeBytes_ = bytesFromMip(firstMip);
+
+        VkBuffer staging = VK_NULL_HANDLE;
+        VkDeviceMemory stagingMem = VK_NULL_HANDLE;
+        if (fromFile) {
+            const size_t size = levels->data.size();
+            device_.createBuffer(size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                staging, stagingMem, MemoryCategory::Staging, "texture streaming");
+
+            void* data{};
+            vkMapMemory(device_.device(), stagingMem, 0, size, 0, &data);
+            std::memcpy(data, levels->data.data(), size);
+            vkUnmapMemory(device_.device(), stagingMem);
+            RenderStats::Get().countTextureUpload(size);
+        }
+
+        //earlier frames on this queue may still sample the old image, wait for them before relayout
+        VkImageMemoryBarrier toCopy[2] = {
+            layoutBarrier(image_, mipLevels_, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                0, VK_ACCESS_TRANSFER_WRITE_BIT),
+            layoutBarrier(oldImage, oldLevels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                0, VK_ACCESS_TRANSFER_READ_BIT),
+        };
+        vkCmdPipelineBarrier(cmd,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 2, toCopy);
+
+        if (fromFile) {
+            std::vector<VkBufferImageCopy> regions(fromFile);
+            for (uint32_t i = 0; i < fromFile; i++)
+            {
+                const MipChain::Level& level = levels->levels[i];
+                VkBufferImageCopy& region = regions[i];
+                region.bufferOffset = level.offset;
+                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.mipLevel = i;
+                region.imageSubresource.layerCount = 1;
+                region.imageExtent = { level.width, level.height, 1 };
+            }
+            vkCmdCopyBufferToImage(cmd, staging, image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uint32_t(regions.size()), regions.data());
+        }
+
+        //the levels both images hold come straight from the old one
+        std::vector<VkImageCopy> copies;
+        for (uint32_t mip = firstMip + fromFile; mip < fullMipLevels(); mip++)
+        {
+            VkImageCopy c{};
+            c.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip - oldFirst, 0, 1 };
+            c.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip - firstMip, 0, 1 };
+            c.extent = { std::max(1u, width_ >> mip), std::max(1u, height_ >> mip), 1 };
+            copies.push_back(c);
+        }
+        vkCmdCopyImage(cmd, oldImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            uint32_t(copies.size()), copies.data());
+
+        VkImageMemoryBarrier toRead = layoutBarrier(image_, mipLevels_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+        vkCmdPipelineBarrier(cmd,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &toRead);
+
+        createView(format_);
+        residentMip_ = firstMip;
+
+        if (oldSet) {
+            // the old set is still bound by in-flight frames, write the new view into a fresh one
+            descriptorSet_ = descriptorAllocator_->allocate(descriptorLayout_);
+            writeDescriptor(descriptorSet_);
+            descriptorAllocator_->free(oldSet, descriptorLayout_);
+        }
+
+        //cmd still reads the old image, so this can only be deferred after it was submitted
+        VkDevice dev = device_.device();
+        c_device* device = &device_;
+        return [dev, device, oldImage, oldMemory, oldView, staging, stagingMem]() {
+            vkDestroyImageView(dev, oldView, c_device::allocator());
+            vkDestroyImage(dev, oldImage, c_device::allocator());
+            device->freeMemory(oldMemory);
+            if (staging) vkDestroyBuffer(dev, staging, c_device::allocator());
+            device->freeMemory(stagingMem);
+        };
     }
 
     Texture2D::~Texture2D() {
-        auto dev = device_.device();
-        if (sampler_)   vkDestroySampler(dev, sampler_, nullptr);
-        if (imageView_) vkDestroyImageView(dev, imageView_, nullptr);
-        if (image_)     vkDestroyImage(dev, image_, nullptr);
-        if (memory_)    vkFreeMemory(dev, memory_, nullptr);
+        if (descriptorSet_ && descriptorAllocator_) descriptorAllocator_->free(descriptorSet_, descriptorLayout_);
+
+        //frames in flight may still sample it, the device destroys it once they're done
+        c_device* device = &device_;
+        VkDevice dev = device_.device();
+        device_.deferDestroy([device, dev, sampler = sampler_, view = imageView_, image = image_, memory = memory_]() {
+            if (sampler) device->releaseSampler(sampler);
+            if (view)    vkDestroyImageView(dev, view, c_device::allocator());
+            if (image)   vkDestroyImage(dev, image, c_device::allocator());
+            if (memory)  device->freeMemory(memory);
+        });
     }
 
-    void Texture2D::createImage(uint32_t w, uint32_t h, VkFormat fmt) {
+    void Texture2D::createImage(uint32_t w, uint32_t h, VkFormat fmt, uint32_t mipLevels) {
+        mipLevels_ = mipLevels;
+        format_ = fmt;
+
         VkImageCreateInfo info{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
         info.imageType = VK_IMAGE_TYPE_2D;
         info.extent = { w,h,1 };
-        info.mipLevels = 1;
+        info.mipLevels = mipLevels;
         info.arrayLayers = 1;
         info.format = fmt;
         info.tiling = VK_IMAGE_TILING_OPTIMAL;
         info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        //transfer src so streaming can copy resident levels into the next image
+        info.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
         info.samples = VK_SAMPLE_COUNT_1_BIT;
         info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        device_.createImageWithInfo(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image_, memory_);
+        device_.createImageWithInfo(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image_, memory_, MemoryCategory::Texture, name_);
     }
 
-    void Texture2D::upload(const void* pixels, size_t size, uint32_t w, uint32_t h) {
-        // staging buffer
+    void Texture2D::upload(const MipChain& chain) {
+        const size_t size = chain.data.size();
+        sizeBytes_ = size;
+
+        // staging buffer, whole chain in one go
         VkBuffer staging;
         VkDeviceMemory stagingMem;
         device_.createBuffer(size,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            staging, stagingMem);
+            staging, stagingMem, MemoryCategory::Staging, "texture upload");
 
         void* data{};
         vkMapMemory(device_.device(), stagingMem, 0, size, 0, &data);
-        std::memcpy(data, pixels, size);
+        std::memcpy(data, chain.data.data(), size);
         vkUnmapMemory(device_.device(), stagingMem);
+        RenderStats::Get().countTextureUpload(size);
 
         // transitions and copy
         VkCommandBuffer cmd = device_.beginSingleTimeCommands();
-        transition(cmd, image_, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        transition(cmd, image_, mipLevels_, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-        VkBufferImageCopy region{};
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.layerCount = 1;
-        region.imageExtent = { w,h,1 };
-        vkCmdCopyBufferToImage(cmd, staging, image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        std::vector<VkBufferImageCopy> regions(chain.levels.size());
+        for (size_t i = 0; i < chain.levels.size(); i++)
+        {
+            const MipChain::Level& level = chain.levels[i];
+            VkBufferImageCopy& region = regions[i];
+            region.bufferOffset = level.offset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = uint32_t(i);
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent = { level.width, level.height, 1 };
+        }
+        vkCmdCopyBufferToImage(cmd, staging, image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uint32_t(regions.size()), regions.data());
 
         // to shader read
         VkImageMemoryBarrier b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
@@ -114,7 +307,7 @@ namespace lavander
         b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         b.image = image_;
         b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        b.subresourceRange.levelCount = 1;
+        b.subresourceRange.levelCount = mipLevels_;
         b.subresourceRange.layerCount = 1;
         vkCmdPipelineBarrier(cmd,
             VK_PIPELINE_STAGE_TRANSFER_BIT,
@@ -123,43 +316,53 @@ namespace lavander
 
         device_.endSingleTimeCommands(cmd);
 
-        vkDestroyBuffer(device_.device(), staging, nullptr);
-        vkFreeMemory(device_.device(), stagingMem, nullptr);
+        vkDestroyBuffer(device_.device(), staging, c_device::allocator());
+        device_.freeMemory(stagingMem);
     }
 
-    void Texture2D::createViewAndSampler(VkFormat fmt) {
-        // view
+    void Texture2D::createViewAndSampler(VkFormat fmt, const TextureSettings& settings) {
+        createView(fmt);
+
+        // sampler
+        VkSamplerCreateInfo s{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+        s.magFilter = settings.filter;
+        s.minFilter = settings.filter;
+        s.addressModeU = s.addressModeV = s.addressModeW = settings.addressMode;
+        s.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        // the view limits the levels, so every texture can share the same full range sampler
+        s.minLod = 0; s.maxLod = VK_LOD_CLAMP_NONE;
+        sampler_ = device_.acquireSampler(s);
+    }
+
+    void Texture2D::createView(VkFormat fmt) {
         VkImageViewCreateInfo iv{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
         iv.image = image_;
         iv.viewType = VK_IMAGE_VIEW_TYPE_2D;
         iv.format = fmt;
+        if (fmt == VK_FORMAT_BC4_UNORM_BLOCK) {
+            // single channel masks read the same through .r and .rgb
+            iv.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_ONE };
+        }
         iv.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        iv.subresourceRange.levelCount = 1;
+        iv.subresourceRange.levelCount = mipLevels_;
         iv.subresourceRange.layerCount = 1;
-        if (vkCreateImageView(device_.device(), &iv, nullptr, &imageView_) != VK_SUCCESS)
+        if (vkCreateImageView(device_.device(), &iv, c_device::allocator(), &imageView_) != VK_SUCCESS)
             throw std::runtime_error("image view failed");
-
-        // sampler
-        VkSamplerCreateInfo s{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
-        s.magFilter = VK_FILTER_LINEAR;
-        s.minFilter = VK_FILTER_LINEAR;
-        s.addressModeU = s.addressModeV = s.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        s.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-        s.minLod = 0; s.maxLod = 0;
-        if (vkCreateSampler(device_.device(), &s, nullptr, &sampler_) != VK_SUCCESS)
-            throw std::runtime_error("sampler failed");
     }
 
-    VkDescriptorSet Texture2D::allocateDescriptor(VkDescriptorPool pool, VkDescriptorSetLayout layout) {
-        VkDescriptorSetAllocateInfo ai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-        ai.descriptorPool = pool;
-        ai.descriptorSetCount = 1;
-        ai.pSetLayouts = &layout;
+    VkDescriptorSet Texture2D::allocateDescriptor(DescriptorAllocator& allocator, VkDescriptorSetLayout layout) {
+        if (descriptorSet_ && descriptorAllocator_) descriptorAllocator_->free(descriptorSet_, descriptorLayout_);
+        VkDescriptorSet set = allocator.allocate(layout);
 
-        VkDescriptorSet set{};
-        if (vkAllocateDescriptorSets(device_.device(), &ai, &set) != VK_SUCCESS)
-            throw std::runtime_error("alloc texture descriptor failed");
+        descriptorAllocator_ = &allocator;
+        descriptorLayout_ = layout;
+        writeDescriptor(set);
 
+        descriptorSet_ = set;
+        return set;
+    }
+
+    void Texture2D::writeDescriptor(VkDescriptorSet set) {
         VkDescriptorImageInfo ii{};
         ii.sampler = sampler_;
         ii.imageView = imageView_;
@@ -172,8 +375,5 @@ namespace lavander
         w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         w.pImageInfo = &ii;
         vkUpdateDescriptorSets(device_.device(), 1, &w, 0, nullptr);
-
-        descriptorSet_ = set;
-        return set;
     }
 }
\ No newline at end of file
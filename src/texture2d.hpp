@@ -1,20 +1,40 @@
 // texture2d.hpp
 #pragma once
 #include <vulkan/vulkan.h>
+#include <functional>
 #include <string>
+#include <vector>
 #include "device.hpp"
+#include "mip_chain.hpp"
+#include "descriptor_allocator.hpp"
 
 namespace lavander {
 
+    // sampler state a texture is created with, also part of the texture cache key
+    struct TextureSettings
+    {
+        VkFilter             filter = VK_FILTER_LINEAR;
+        VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        bool                 generateMips = true;
+        bool                 srgb = true; // false for data textures (normal maps, masks)
+
+        bool operator==(const TextureSettings& o) const
+        {
+            return filter == o.filter && addressMode == o.addressMode &&
+                generateMips == o.generateMips && srgb == o.srgb;
+        }
+    };
+
     class Texture2D {
     public:
-        // Load from file (RGBA via stb), or make a 1x1 color
-        Texture2D(c_device& device, const std::string& path);
+        // Load from file (RGBA via stb, or pre-compressed .ktx2 from TextureCooker), or make a 1x1 color
+        Texture2D(c_device& device, const std::string& path, const TextureSettings& settings = {});
         Texture2D(c_device& device, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
         ~Texture2D();
 
-        // Create (and cache) a descriptor set for this texture (set = material set)
-        VkDescriptorSet allocateDescriptor(VkDescriptorPool pool, VkDescriptorSetLayout layout);
+        // Create (and cache) a descriptor set for this texture (set = material set), it goes
+        // back to the allocator when the texture dies
+        VkDescriptorSet allocateDescriptor(DescriptorAllocator& allocator, VkDescriptorSetLayout layout);
 
         // Getters
         VkDescriptorSet descriptorSet() const { return descriptorSet_; }
@@ -22,19 +42,58 @@ namespace lavander {
         VkSampler       sampler()       const { return sampler_; }
         uint32_t        width()         const { return width_; }
         uint32_t        height()        const { return height_; }
+        uint32_t        mipLevels()     const { return mipLevels_; }
+        VkFormat        format()        const { return format_; }
+        size_t          sizeBytes()     const { return sizeBytes_; }
+
+        // Mip streaming, only .ktx2 textures with a mip chain can stream: they start with the
+        // small levels resident and mip `residentMip()` of the full chain as their top level.
+        bool     streamable()    const { return !streamPath_.empty(); }
+        uint32_t residentMip()   const { return residentMip_; }
+        uint32_t fullMipLevels() const { return uint32_t(levelBytes_.size()); }
+        uint32_t lowestStreamMip() const { return lowestStreamMip_; }
+        size_t   bytesFromMip(uint32_t firstMip) const;
+
+        const std::string& streamPath() const { return streamPath_; }
+
+        // Records the switch to an image holding full chain levels [firstMip, end) into cmd,
+        // ahead of the passes that sample it. Levels already resident are copied over on the
+        // GPU; `levels` holds the ones above them (full mips [firstMip, residentMip()), read off
+        // the render thread) and is null when streaming out. View and set switch right away,
+        // so later draws in cmd see the new image. Returns the release of the old image and
+        // the staging buffer, to be deferred once cmd is submitted; empty if nothing changed.
+        std::function<void()> recordStreamTo(VkCommandBuffer cmd, uint32_t firstMip, const MipChain* levels);
+
+        // largest extent of the levels a texture starts with when it streams
+        static constexpr uint32_t kInitialResidentExtent = 128;
 
     private:
-        void createImage(uint32_t w, uint32_t h, VkFormat fmt);
-        void upload(const void* pixels, size_t size, uint32_t w, uint32_t h);
-        void createViewAndSampler(VkFormat fmt);
+        void loadCompressed(const std::string& path, const TextureSettings& settings);
+        void createImage(uint32_t w, uint32_t h, VkFormat fmt, uint32_t mipLevels);
+        void upload(const MipChain& chain);
+        void createViewAndSampler(VkFormat fmt, const TextureSettings& settings);
+        void createView(VkFormat fmt);
+        void writeDescriptor(VkDescriptorSet set);
 
         c_device& device_;
+        std::string    name_ = "solid color"; // source path, labels the memory accounting
         VkImage        image_ = VK_NULL_HANDLE;
         VkDeviceMemory memory_ = VK_NULL_HANDLE;
         VkImageView    imageView_ = VK_NULL_HANDLE;
         VkSampler      sampler_ = VK_NULL_HANDLE;
         VkDescriptorSet descriptorSet_ = VK_NULL_HANDLE;
         uint32_t       width_ = 0, height_ = 0;
+        uint32_t       mipLevels_ = 1;
+        VkFormat       format_ = VK_FORMAT_UNDEFINED;
+        size_t         sizeBytes_ = 0;
+
+        DescriptorAllocator*  descriptorAllocator_ = nullptr;
+        VkDescriptorSetLayout descriptorLayout_ = VK_NULL_HANDLE;
+
+        std::string           streamPath_;
+        std::vector<uint64_t> levelBytes_;
+        uint32_t              residentMip_ = 0;
+        uint32_t              lowestStreamMip_ = 0;
     };
 
 } // namespace lavander
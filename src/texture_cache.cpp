@@ -0,0 +1,120 @@
+#include "texture_cache.hpp"
+#include "cpu_profiler.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+namespace lavander
+{
+    TextureCache::TextureCache(c_device& device, DescriptorAllocator& descriptors, VkDescriptorSetLayout layout)
+        : device(device), materialDescriptors(descriptors), materialSetLayout(layout)
+    {
+    }
+
+    size_t TextureCache::KeyHash::operator()(const Key& k) const
+    {
+        size_t h = std::hash<std::string>{}(k.path);
+        h ^= (size_t(k.settings.filter) + 0x9e3779b9 + (h << 6) + (h >> 2));
+        h ^= (size_t(k.settings.addressMode) + 0x9e3779b9 + (h << 6) + (h >> 2));
+        h ^= (size_t(k.settings.generateMips) | (size_t(k.settings.srgb) << 1)) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+
+    std::string TextureCache::canonicalPath(const std::string& path)
+    {
+        std::error_code ec;
+        std::filesystem::path p = std::filesystem::weakly_canonical(path, ec);
+        if (ec)
+        {
+            p = std::filesystem::path(path).lexically_normal();
+        }
+        return p.generic_string();
+    }
+
+    std::shared_ptr<Texture2D> TextureCache::acquire(const std::string& path, const TextureSettings& settings)
+    {
+        PROFILE_SCOPE("TextureCache::acquire");
+        Key key{ canonicalPath(path), settings };
+
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            if (auto tex = it->second.texture.lock())
+            {
+                it->second.lastUse = ++useCounter;
+                return tex;
+            }
+            entries.erase(it);
+        }
+
+        auto tex = std::make_shared<Texture2D>(device, key.path, settings);
+        tex->allocateDescriptor(materialDescriptors, materialSetLayout);
+
+        Entry entry;
+        entry.texture = tex;
+        entry.lastUse = ++useCounter;
+        entry.bytes = tex->sizeBytes();
+        if (retentionBudget > 0)
+        {
+            entry.retained = tex;
+        }
+        entries.emplace(std::move(key), std::move(entry));
+
+        return tex;
+    }
+
+    void TextureCache::collect()
+    {
+        //idle = only the cache itself still holds it
+        std::vector<Entry*> idle;
+        for (auto& [key, entry] : entries)
+        {
+            if (entry.retained && entry.retained.use_count() == 1)
+            {
+                idle.push_back(&entry);
+            }
+        }
+
+        std::sort(idle.begin(), idle.end(), [](const Entry* a, const Entry* b) { return a->lastUse > b->lastUse; });
+
+        size_t kept = 0;
+        for (Entry* entry : idle)
+        {
+            if (kept + entry->bytes <= retentionBudget)
+            {
+                kept += entry->bytes;
+                continue;
+            }
+            entry->retained.reset();
+        }
+
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->second.texture.expired())
+            {
+                it = entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void TextureCache::clear()
+    {
+        entries.clear();
+    }
+
+    size_t TextureCache::residentBytes() const
+    {
+        size_t total = 0;
+        for (auto& [key, entry] : entries)
+        {
+            if (!entry.texture.expired()) total += entry.bytes;
+        }
+        return total;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "texture2d.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace lavander
+{
+    // Hands out shared Texture2D handles keyed by canonical path + sampler settings.
+    // Entries only hold weak references, so a texture is destroyed when its last user
+    // releases it. With a retention budget, recently released textures are kept alive
+    // (least recently used first to go) so re-picking an asset doesn't hit the disk again.
+    class TextureCache
+    {
+    public:
+        TextureCache(c_device& device, DescriptorAllocator& materialDescriptors, VkDescriptorSetLayout materialSetLayout);
+
+        TextureCache(const TextureCache&) = delete;
+        TextureCache& operator=(const TextureCache&) = delete;
+
+        std::shared_ptr<Texture2D> acquire(const std::string& path, const TextureSettings& settings = {});
+
+        //drops dead entries and trims idle retained textures to the budget, call once per frame
+        void collect();
+        void clear();
+
+        void   setRetentionBudgetMB(size_t mb) { retentionBudget = mb * 1024 * 1024; }
+        size_t retentionBudgetBytes() const { return retentionBudget; }
+        size_t residentBytes() const;
+        size_t size() const { return entries.size(); }
+
+    private:
+        struct Key
+        {
+            std::string     path;
+            TextureSettings settings;
+
+            bool operator==(const Key& o) const { return path == o.path && settings == o.settings; }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& k) const;
+        };
+
+        struct Entry
+        {
+            std::weak_ptr<Texture2D>   texture;
+            std::shared_ptr<Texture2D> retained; // only set while a retention budget is active
+            uint64_t lastUse = 0;
+            size_t   bytes = 0;
+        };
+
+        static std::string canonicalPath(const std::string& path);
+
+        c_device& device;
+        DescriptorAllocator&  materialDescriptors;
+        VkDescriptorSetLayout materialSetLayout;
+
+        std::unordered_map<Key, Entry, KeyHash> entries;
+        size_t   retentionBudget = 0;
+        uint64_t useCounter = 0;
+    };
+}
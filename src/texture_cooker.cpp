@@ -0,0 +1,187 @@
+#include "texture_cooker.hpp"
+#include "ktx2.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#define STB_DXT_IMPLEMENTATION
+#include "stb_dxt.h"
+#include "stb_image.h"
+
+namespace lavander
+{
+    namespace
+    {
+        //gathers a 4x4 block, clamping at the edges so partial blocks are padded with edge texels
+        void fetchBlock(const uint8_t* rgba, uint32_t w, uint32_t h, uint32_t bx, uint32_t by, uint8_t out[64])
+        {
+            for (uint32_t y = 0; y < 4; y++)
+            {
+                uint32_t sy = std::min(by * 4 + y, h - 1);
+                for (uint32_t x = 0; x < 4; x++)
+                {
+                    uint32_t sx = std::min(bx * 4 + x, w - 1);
+                    const uint8_t* p = rgba + (size_t(sy) * w + sx) * 4;
+                    uint8_t* o = out + (y * 4 + x) * 4;
+                    o[0] = p[0]; o[1] = p[1]; o[2] = p[2]; o[3] = p[3];
+                }
+            }
+        }
+
+        void encodeBlock(VkFormat format, const uint8_t block[64], uint8_t* dst)
+        {
+            switch (format)
+            {
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                stb_compress_dxt_block(dst, block, 0, STB_DXT_HIGHQUAL);
+                break;
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+                stb_compress_dxt_block(dst, block, 1, STB_DXT_HIGHQUAL);
+                break;
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+            {
+                uint8_t r[16];
+                for (int i = 0; i < 16; i++) r[i] = block[i * 4];
+                stb_compress_bc4_block(dst, r);
+                break;
+            }
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            {
+                uint8_t rg[32];
+                for (int i = 0; i < 16; i++) { rg[i * 2] = block[i * 4]; rg[i * 2 + 1] = block[i * 4 + 1]; }
+                stb_compress_bc5_block(dst, rg);
+                break;
+            }
+            default:
+                throw std::runtime_error("texture cooker: unsupported target format");
+            }
+        }
+
+        bool endsWithAny(const std::string& s, std::initializer_list<const char*> suffixes)
+        {
+            for (const char* suffix : suffixes)
+            {
+                std::string suf = suffix;
+                if (s.size() >= suf.size() && s.compare(s.size() - suf.size(), suf.size(), suf) == 0) return true;
+            }
+            return false;
+        }
+    }
+
+    TextureUsage TextureCooker::UsageFromPath(const std::string& path)
+    {
+        std::string stem = std::filesystem::path(path).stem().string();
+        std::transform(stem.begin(), stem.end(), stem.begin(), ::tolower);
+
+        if (endsWithAny(stem, { "_n", "_nrm", "_normal", "_normals" })) return TextureUsage::NormalMap;
+        if (endsWithAny(stem, { "_mask", "_rough", "_roughness", "_ao", "_metal", "_metallic", "_height" })) return TextureUsage::Mask;
+        return TextureUsage::Color;
+    }
+
+    VkFormat TextureCooker::ChooseFormat(const uint8_t* rgba, uint32_t width, uint32_t height, TextureUsage usage)
+    {
+        if (usage == TextureUsage::NormalMap) return VK_FORMAT_BC5_UNORM_BLOCK;
+        if (usage == TextureUsage::Mask) return VK_FORMAT_BC4_UNORM_BLOCK;
+
+        bool usesAlpha = false;
+        for (size_t i = 0; i < size_t(width) * height && !usesAlpha; i++)
+        {
+            usesAlpha = rgba[i * 4 + 3] != 255;
+        }
+        return usesAlpha ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+    }
+
+    MipChain TextureCooker::Compress(const MipChain& rgba, VkFormat format)
+    {
+        const uint32_t blockBytes = BlockBytes(format);
+
+        MipChain out;
+        size_t total = 0;
+        for (const MipChain::Level& level : rgba.levels)
+        {
+            uint32_t bx = (level.width + 3) / 4;
+            uint32_t by = (level.height + 3) / 4;
+            size_t size = size_t(bx) * by * blockBytes;
+            out.levels.push_back({ level.width, level.height, total, size });
+            total += size;
+        }
+        out.data.resize(total);
+
+        const uint32_t workers = std::max(1u, std::thread::hardware_concurrency());
+
+        for (size_t li = 0; li < rgba.levels.size(); li++)
+        {
+            const MipChain::Level& src = rgba.levels[li];
+            const MipChain::Level& dst = out.levels[li];
+            const uint32_t bx = (src.width + 3) / 4;
+            const uint32_t by = (src.height + 3) / 4;
+            const uint8_t* pixels = rgba.data.data() + src.offset;
+            uint8_t* blocks = out.data.data() + dst.offset;
+
+            //rows of blocks are independent, hand each worker a contiguous band
+            auto encodeRows = [&](uint32_t rowBegin, uint32_t rowEnd)
+            {
+                uint8_t block[64];
+                for (uint32_t y = rowBegin; y < rowEnd; y++)
+                {
+                    for (uint32_t x = 0; x < bx; x++)
+                    {
+                        fetchBlock(pixels, src.width, src.height, x, y, block);
+                        encodeBlock(format, block, blocks + (size_t(y) * bx + x) * blockBytes);
+                    }
+                }
+            };
+
+            uint32_t threadCount = std::min(workers, by);
+            if (threadCount <= 1)
+            {
+                encodeRows(0, by);
+                continue;
+            }
+
+            std::vector<std::thread> threads;
+            uint32_t band = (by + threadCount - 1) / threadCount;
+            for (uint32_t t = 0; t < threadCount; t++)
+            {
+                uint32_t begin = t * band;
+                uint32_t end = std::min(by, begin + band);
+                if (begin >= end) break;
+                threads.emplace_back(encodeRows, begin, end);
+            }
+            for (auto& th : threads) th.join();
+        }
+
+        return out;
+    }
+
+    TextureCooker::Result TextureCooker::CookFile(const std::string& inPath, const std::string& outPath, TextureUsage usage)
+    {
+        int w, h, comp;
+        stbi_uc* pixels = stbi_load(inPath.c_str(), &w, &h, &comp, STBI_rgb_alpha);
+        if (!pixels) throw std::runtime_error("texture cooker: failed to load " + inPath);
+
+        if (usage == TextureUsage::Auto) usage = UsageFromPath(inPath);
+
+        Result result;
+        result.width = uint32_t(w);
+        result.height = uint32_t(h);
+        result.format = ChooseFormat(pixels, result.width, result.height, usage);
+
+        const bool srgb = usage == TextureUsage::Color;
+        MipChain chain = MipChain::Generate(pixels, result.width, result.height, srgb);
+        stbi_image_free(pixels);
+
+        MipChain compressed = Compress(chain, result.format);
+        Ktx2File::Write(outPath, result.format, compressed);
+
+        result.sourceBytes = chain.data.size();
+        result.cookedBytes = compressed.data.size();
+        return result;
+    }
+}
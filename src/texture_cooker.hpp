@@ -0,0 +1,41 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "mip_chain.hpp"
+
+#include <string>
+
+namespace lavander
+{
+    enum class TextureUsage
+    {
+        Auto,      // normal maps and masks by file name (_n/_normal, _mask/_rough/_ao...), the rest is Color
+        Color,     // BC1, or BC3 when alpha is used (sRGB); grey stays BC1, BC4 has no sRGB format
+        NormalMap, // BC5, two channel unorm
+        Mask       // BC4, single channel unorm
+    };
+
+    // Offline texture cooker: loads an image, builds its mip chain and block compresses
+    // every level on worker threads, then writes the result as a .ktx2 that Texture2D
+    // uploads without touching the blocks again.
+    class TextureCooker
+    {
+    public:
+        struct Result
+        {
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            size_t   sourceBytes = 0;
+            size_t   cookedBytes = 0;
+        };
+
+        static Result CookFile(const std::string& inPath, const std::string& outPath, TextureUsage usage = TextureUsage::Auto);
+
+        //NormalMap and Mask pick their format outright, Color picks BC3 over BC1 when any texel uses alpha
+        static VkFormat ChooseFormat(const uint8_t* rgba, uint32_t width, uint32_t height, TextureUsage usage);
+        static TextureUsage UsageFromPath(const std::string& path);
+
+        //compresses every level of an RGBA8 chain into `format`, blocks are split across threads
+        static MipChain Compress(const MipChain& rgba, VkFormat format);
+    };
+}
@@ -0,0 +1,258 @@
+#include "texture_streamer.hpp"
+#include "components.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "ktx2.hpp"
+
+namespace lavander
+{
+    TextureStreamer::TextureStreamer(c_device& device) : device(device)
+    {
+        loaderThread = std::thread(&TextureStreamer::loader, this);
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        loadCv.notify_all();
+        loaderThread.join();
+
+        //a frame may have recorded swaps without getting to endFrame()
+        for (auto& release : retired) device.deferDestroy(std::move(release));
+    }
+
+    void TextureStreamer::loader()
+    {
+        for (;;)
+        {
+            Load load;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                loadCv.wait(lock, [this] { return stopping || !requests.empty(); });
+                if (stopping) return;
+
+                load = std::move(requests.front());
+                requests.pop_front();
+            }
+
+            try
+            {
+                Ktx2File file(load.path);
+                load.levels = file.readLevels(load.firstMip, load.residentMip - load.firstMip);
+            }
+            catch (const std::exception& e)
+            {
+                //record() drops it, the texture is planned again next frame
+                std::cerr << "texture stream read failed: " << e.what() << std::endl;
+                load.failed = true;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            loaded.push_back(std::move(load));
+        }
+    }
+
+    void TextureStreamer::observe(const std::shared_ptr<Texture2D>& texture, const glm::vec3& position, float scale,
+        float uvDensity, const Camera& camera, float viewportHeight)
+    {
+        if (!texture || !texture->streamable()) return;
+
+        //cheap visibility: anything fully behind the camera doesn't pull detail in
+        float dist = glm::dot(position - camera.getPosition(), camera.getForward());
+        if (dist < -scale) return;
+        dist = std::max(dist, camera.getNearClip());
+
+        float pixelsPerUnit = camera.isOrtho()
+            ? viewportHeight / (2.0f * camera.getOrthoSize())
+            : viewportHeight / (2.0f * dist * std::tan(glm::radians(camera.getFovDegrees()) * 0.5f));
+
+        float texelsPerUnit = float(std::max(texture->width(), texture->height())) * uvDensity / std::max(scale, 1e-4f);
+        float ratio = texelsPerUnit / std::max(pixelsPerUnit, 1e-4f);
+
+        uint32_t mip = ratio > 1.0f ? uint32_t(std::floor(std::log2(ratio))) : 0u;
+        mip = std::min(mip, texture->lowestStreamMip());
+
+        float extent = scale * pixelsPerUnit;
+
+        Tracked& t = tracked[texture.get()];
+        t.desiredMip = (t.lastSeen == frame) ? std::min(t.desiredMip, mip) : mip;
+        t.coverage += extent * extent;
+        t.lastSeen = frame;
+        t.texture = texture;
+    }
+
+    void TextureStreamer::gather(ECSRegistry& registry, const Camera& camera, float viewportHeight)
+    {
+        auto scaleOf = [](const Transform& t)
+        {
+            return std::max({ std::abs(t.scale.x), std::abs(t.scale.y), std::abs(t.scale.z) });
+        };
+
+        for (auto& [entity, sprites] : registry.getAllComponentsOfType<SpriteRenderer>())
+        {
+            auto* transforms = registry.getComponents<Transform>(entity);
+            if (!transforms) continue;
+
+            for (auto& sprite : sprites)
+            {
+                //unit quad with 0..1 uvs
+                for (auto& t : *transforms) observe(sprite.texture, t.position, scaleOf(t), 1.0f, camera, viewportHeight);
+            }
+        }
+
+        for (auto& [entity, renderers] : registry.getAllComponentsOfType<MeshRenderer3D>())
+        {
+            auto* filters = registry.getComponents<MeshFilter>(entity);
+            auto* transforms = registry.getComponents<Transform>(entity);
+            if (!filters || !transforms || filters->empty() || !(*filters)[0].mesh) continue;
+
+            float uvDensity = (*filters)[0].mesh->uvDensity();
+            for (auto& r : renderers)
+            {
+                for (auto& t : *transforms) observe(r.texture, t.position, scaleOf(t), uvDensity, camera, viewportHeight);
+            }
+        }
+    }
+
+    void TextureStreamer::update(ECSRegistry& registry, const Camera& camera, float viewportHeight)
+    {
+        frame++;
+
+        for (auto& [tex, t] : tracked) t.coverage = 0.0f;
+        gather(registry, camera, viewportHeight);
+
+        struct Plan
+        {
+            std::shared_ptr<Texture2D> texture;
+            uint32_t target;
+            float    coverage;
+            bool     budgetLimited;
+        };
+
+        std::vector<Plan> plans;
+        size_t baseline = 0;
+        for (auto it = tracked.begin(); it != tracked.end();)
+        {
+            auto tex = it->second.texture.lock();
+            if (!tex)
+            {
+                it = tracked.erase(it);
+                continue;
+            }
+
+            uint32_t target = it->second.desiredMip;
+            if (frame - it->second.lastSeen > evictAfterFrames) target = tex->lowestStreamMip();
+
+            baseline += tex->bytesFromMip(tex->lowestStreamMip());
+            plans.push_back({ std::move(tex), target, it->second.coverage, false });
+            ++it;
+        }
+
+        //the low levels are always resident, split what's left of the budget by screen coverage
+        std::sort(plans.begin(), plans.end(), [](const Plan& a, const Plan& b) { return a.coverage > b.coverage; });
+
+        size_t remaining = budget > baseline ? budget - baseline : 0;
+        for (Plan& p : plans)
+        {
+            const uint32_t lowest = p.texture->lowestStreamMip();
+            const size_t lowestBytes = p.texture->bytesFromMip(lowest);
+
+            uint32_t mip = p.target;
+            while (mip < lowest && p.texture->bytesFromMip(mip) - lowestBytes > remaining)
+            {
+                mip++;
+                p.budgetLimited = true;
+            }
+            remaining -= p.texture->bytesFromMip(mip) - lowestBytes;
+            p.target = mip;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        //stream out first, least covered first; whatever misses the cap goes next frame
+        streamOuts.clear();
+        bool overBudget = false;
+        for (auto it = plans.rbegin(); it != plans.rend(); ++it)
+        {
+            Plan& p = *it;
+            const uint32_t current = p.texture->residentMip();
+            //a read in flight was sized for the current image, leave the texture alone until it lands
+            if (loading.count(p.texture.get())) continue;
+
+            //one level of hysteresis so textures near a boundary don't flip every frame
+            if (p.target <= current || (!p.budgetLimited && p.target < current + 2)) continue;
+
+            if (streamOuts.size() >= maxStreamOutsPerFrame)
+            {
+                overBudget = overBudget || p.budgetLimited;
+                continue;
+            }
+            streamOuts.push_back({ p.texture, p.budgetLimited ? p.target : p.target - 1 });
+        }
+
+        //the plan assumed every stream-out happened, hold reads until the deferred ones made room;
+        //reads in flight count against the upload cap so a slow disk doesn't pile up requests
+        resident = 0;
+        for (Plan& p : plans)
+        {
+            const uint32_t current = p.texture->residentMip();
+            if (!overBudget && p.target < current && loading.size() < maxUploadsPerFrame &&
+                loading.insert(p.texture.get()).second)
+            {
+                Load load;
+                load.texture = p.texture;
+                load.key = p.texture.get();
+                load.path = p.texture->streamPath();
+                load.firstMip = p.target;
+                load.residentMip = current;
+                requests.push_back(std::move(load));
+                loadCv.notify_one();
+            }
+
+            resident += p.texture->bytesFromMip(current);
+        }
+    }
+
+    void TextureStreamer::record(VkCommandBuffer cmd)
+    {
+        std::vector<Load> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(loaded);
+        }
+
+        for (StreamOut& out : streamOuts)
+        {
+            auto texture = out.texture.lock();
+            if (!texture) continue;
+            if (auto release = texture->recordStreamTo(cmd, out.firstMip, nullptr)) retired.push_back(std::move(release));
+        }
+        streamOuts.clear();
+
+        for (Load& load : ready)
+        {
+            auto texture = load.texture.lock();
+            //texture gone, read failed or its image changed since the read was planned: drop it
+            if (texture && !load.failed && texture->residentMip() == load.residentMip)
+            {
+                if (auto release = texture->recordStreamTo(cmd, load.firstMip, &load.levels)) retired.push_back(std::move(release));
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            loading.erase(load.key);
+        }
+    }
+
+    void TextureStreamer::endFrame()
+    {
+        //deferred now, they wait for the submission that still copies from them
+        for (auto& release : retired) device.deferDestroy(std::move(release));
+        retired.clear();
+    }
+}
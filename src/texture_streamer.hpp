@@ -0,0 +1,102 @@
+#pragma once
+#include "texture2d.hpp"
+#include "ecs_registry.hpp"
+#include "camera.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace lavander
+{
+    // Decides which mip every streamable texture should have resident from how large it
+    // shows up on screen, then streams levels in (highest screen coverage first) and out
+    // so the total stays under the budget.
+    //
+    // Nothing blocks the render thread: new levels are read from disk on a loader thread,
+    // and every swap is recorded into the frame's command buffer ahead of the scene pass
+    // (stream-outs copy the resident levels GPU side). The old images are released once
+    // the frame that copied from them has finished.
+    class TextureStreamer
+    {
+    public:
+        explicit TextureStreamer(c_device& device);
+        ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        //call once per frame before recording, viewportHeight in pixels; plans and queues reads
+        void update(ECSRegistry& registry, const Camera& camera, float viewportHeight);
+        //records this frame's swaps, before any pass that samples textures
+        void record(VkCommandBuffer cmd);
+        //call right after the frame's submit, hands the replaced images to the deletion queue
+        void endFrame();
+
+        void   setBudgetMB(size_t mb) { budget = mb * 1024 * 1024; }
+        void   setMaxUploadsPerFrame(uint32_t n) { maxUploadsPerFrame = n; }
+        //stream-outs copy into a smaller image, capped separately so a budget drop spreads over frames
+        void   setMaxStreamOutsPerFrame(uint32_t n) { maxStreamOutsPerFrame = n; }
+        //frames a texture may go unseen before its detail levels get dropped
+        void   setEvictAfterFrames(uint32_t n) { evictAfterFrames = n; }
+        size_t residentBytes() const { return resident; }
+
+    private:
+        struct Tracked
+        {
+            std::weak_ptr<Texture2D> texture;
+            uint64_t lastSeen = 0;
+            uint32_t desiredMip = 0;
+            float    coverage = 0.0f; // summed projected area in pixels, this frame
+        };
+
+        struct Load
+        {
+            std::weak_ptr<Texture2D> texture;
+            Texture2D* key = nullptr; // entry in `loading`
+            std::string path;
+            uint32_t firstMip = 0;
+            uint32_t residentMip = 0; // levels read are [firstMip, residentMip)
+            MipChain levels;
+            bool     failed = false;
+        };
+
+        struct StreamOut
+        {
+            std::weak_ptr<Texture2D> texture;
+            uint32_t firstMip = 0;
+        };
+
+        void gather(ECSRegistry& registry, const Camera& camera, float viewportHeight);
+        void observe(const std::shared_ptr<Texture2D>& texture, const glm::vec3& position, float scale,
+            float uvDensity, const Camera& camera, float viewportHeight);
+        void loader();
+
+        c_device& device;
+        std::unordered_map<Texture2D*, Tracked> tracked;
+
+        std::thread loaderThread;
+        std::mutex mutex;
+        std::condition_variable loadCv;
+        std::deque<Load> requests;
+        std::vector<Load> loaded;               // read, waiting for record()
+        std::unordered_set<Texture2D*> loading; // requested or loaded, not yet recorded
+        bool stopping = false;
+
+        std::vector<StreamOut> streamOuts;          // planned this frame
+        std::vector<std::function<void()>> retired; // recorded this frame, released after submit
+
+        uint64_t frame = 0;
+        size_t   budget = 256ull * 1024 * 1024;
+        size_t   resident = 0;
+        uint32_t maxUploadsPerFrame = 2;
+        uint32_t maxStreamOutsPerFrame = 4;
+        uint32_t evictAfterFrames = 120;
+    };
+}
@@ -1,4 +1,5 @@
 #include "window.hpp"
+#include "host_allocator.hpp"
 
 #include <stdexcept>
 
@@ -20,14 +21,24 @@ namespace lavander {
     {
         glfwInit();
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
         window = glfwCreateWindow(width, height, windowName.c_str(), nullptr, nullptr);
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+    }
+
+    void c_window::framebufferResizeCallback(GLFWwindow *window, int width, int height)
+    {
+        auto self = reinterpret_cast<c_window *>(glfwGetWindowUserPointer(window));
+        self->framebufferResized = true;
+        self->width = width;
+        self->height = height;
     }
 
     void c_window::createWindowSurface(VkInstance instance, VkSurfaceKHR *surface)
     {
-        if (glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS)
+        if (glfwCreateWindowSurface(instance, window, HostAllocator::Get().callbacks(), surface) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create window surface");
         }
@@ -23,15 +23,21 @@ namespace lavander {
             };
         }
 
+        //set by the framebuffer size callback, cleared once the swapchain caught up
+        bool wasWindowResized() { return framebufferResized; }
+        void resetWindowResizedFlag() { framebufferResized = false; }
+
         void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
 
         GLFWwindow* getGLFWwindow() const { return window; }
 
         private:
+        static void framebufferResizeCallback(GLFWwindow *window, int width, int height);
         void initWindow();
 
-        const int width;
-        const int height;
+        int width;
+        int height;
+        bool framebufferResized = false;
 
         std::string windowName;
         GLFWwindow *window;